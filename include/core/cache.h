@@ -0,0 +1,41 @@
+#pragma once
+
+#ifndef _CACHE_H_
+#define _CACHE_H_ 1
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "core/futoshiki.h"
+
+/*
+ * Bounded cache of search results, shared by puzzles that are equivalent up
+ * to symmetry (rotations, reflections and the value flip v -> size + 1 - v).
+ * Puzzles are looked up by a canonical form of their values and
+ * inequalities, and a cached solution is mapped back to the orientation of
+ * the puzzle being solved. When full, entries are evicted with the CLOCK
+ * policy. A cache may be shared by several threads.
+ */
+
+typedef struct SolveCache SolveCache;
+
+/**
+ * Creates a cache holding the results of up to <capacity> puzzles.
+ */
+SolveCache *solvecache_new(size_t);
+void solvecache_destroy(SolveCache *);
+
+/**
+ * Same as puzzle_solvePortfolio (puzzle_solve with a single thread), but
+ * answers from the cache when an equivalent puzzle was already solved or
+ * proven unsatisfiable, without any assignment. Only these two outcomes are
+ * cached.
+ */
+SolveStatus solvecache_solve(SolveCache *, Puzzle *, const SolveOptions *, int, int64_t *);
+
+/**
+ * Number of searches answered from the cache and number of searches run.
+ */
+void solvecache_counters(SolveCache *, uint64_t *hits, uint64_t *misses);
+
+#endif /* ifndef _CACHE_H_ */
@@ -0,0 +1,46 @@
+#pragma once
+
+#ifndef _CHECKPOINT_H_
+#define _CHECKPOINT_H_ 1
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "core/futoshiki.h"
+
+/*
+ * Saved state of a search, from which it can be continued after its process
+ * is stopped. A search with SolveOptions::checkpoint set saves, every
+ * checkpointInterval nanoseconds, the value being tried at each depth of
+ * the current path, its assignment and solution counts and the grids in
+ * its transposition table. The file is replaced atomically and is only
+ * read back by the same build on the same kind of machine.
+ *
+ * A search given a saved state in SolveOptions::resume replays the path
+ * before taking any other decision and then goes on exactly as the saved
+ * search would, with the same answer and final assignment count, as long as
+ * it solves the same puzzle with the same configuration and, when counting,
+ * also counts. Statistics and traces only cover the resumed part.
+ */
+
+/**
+ * Reads the state saved in the given file. Returns NULL if the file cannot
+ * be read or does not hold a saved state.
+ */
+Checkpoint *checkpoint_read(const char *);
+void checkpoint_destroy(Checkpoint *);
+
+/**
+ * Returns the SolveOptions::checkpointTag of the search that saved the
+ * state.
+ */
+uint64_t checkpoint_tag(const Checkpoint *);
+
+/**
+ * Whether the state was saved by a search of the given Puzzle, not yet
+ * searched, with the given configuration, counting solutions or not. A
+ * search given a state that does not match is cancelled before starting.
+ */
+bool checkpoint_matches(const Checkpoint *, const Puzzle *, const SolverConfig *, bool counting);
+
+#endif /* ifndef _CHECKPOINT_H_ */
@@ -9,16 +9,222 @@
 #define OPT_LEVEL OPT_SIMPLIFY
 #define ASSIGN_MAX 1e6
 
+// Nodes between checks of the deadline and cancellation flag
+#define CHECK_INTERVAL 1024
+
+// Default number of values tested by each probing pass
+#define PROBE_BUDGET 4096
+
+// Default time between checkpoints, in nanoseconds
+#define CHECKPOINT_INTERVAL 60000000000ull
+
+// Default number of random paths taken by puzzle_estimate, and assignments
+// after which it stops taking more
+#define ESTIMATE_PROBES 64
+#define ESTIMATE_BUDGET 20000
+
 #include <stdio.h>
+#include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
 
 typedef struct Puzzle Puzzle;
+typedef struct SolveStats SolveStats;
+typedef struct Trace Trace;
+typedef struct TransTable TransTable;
+typedef struct Checkpoint Checkpoint;
+
+/**
+ * Order in which the values of a cell are tried during the search.
+ */
+typedef enum ValueOrder {
+    ORDER_ASCENDING,
+    ORDER_DESCENDING,
+    ORDER_RANDOM
+} ValueOrder;
+
+/**
+ * Heuristics used by a search. The defaults follow OPT_LEVEL.
+ */
+typedef struct SolverConfig {
+    bool forwardChecking;
+    bool mvr;
+
+    // Also reject states where some inequality can no longer be satisfied
+    bool ineqCheck;
+
+    // Only search for solutions that are the smallest of their orbit under
+    // the symmetries of the puzzle, see core/symmetry.h
+    bool symmetryBreaking;
+
+    ValueOrder order;
+    unsigned int seed;
+
+    // Before branching at nodes above this depth (0 for none), assert each
+    // possible value of each empty cell, fill in the cells left with a
+    // single value and rule the value out if some cell or inequality is
+    // left without options; at most probeBudget values are tested per
+    // node (0 for no limit)
+    unsigned int probeDepth;
+    unsigned int probeBudget;
+} SolverConfig;
+
+/**
+ * Limits and settings of a single call to puzzle_solve.
+ */
+typedef struct SolveOptions {
+    SolverConfig config;
+
+    // Search gives up after this many assignments
+    int64_t maxAssignments;
+
+    // Point of futoshiki_now() after which the search gives up, 0 for none
+    uint64_t deadline;
+
+    // Search gives up as soon as this becomes true (may be NULL)
+    const atomic_bool *cancel;
+
+    // Number of nodes between checks of deadline and cancel; 0 is taken as
+    // 1, checking at every node
+    unsigned int checkInterval;
+
+    // Cleared and filled by the search when compiled with FUTOSHIKI_STATS
+    // (may be NULL), see core/stats.h
+    SolveStats *stats;
+
+    // Receives the events of the search (may be NULL), see core/trace.h
+    Trace *trace;
+
+    // Grids already proven unsolvable, shared with other searches of the
+    // same puzzle (may be NULL), see core/transtable.h
+    TransTable *transpositions;
+
+    // File where the state of the search is saved every checkpointInterval
+    // nanoseconds (may be NULL), along with checkpointTag, and a state saved
+    // by an earlier search to continue from (may be NULL). Ignored by
+    // puzzle_solvePortfolio and puzzle_solveSplit, see core/checkpoint.h
+    const char *checkpoint;
+    uint64_t checkpointInterval;
+    uint64_t checkpointTag;
+    const Checkpoint *resume;
+} SolveOptions;
+
+/**
+ * Outcome of a search.
+ */
+typedef enum SolveStatus {
+    SOLVE_SOLVED,
+    SOLVE_UNSAT,
+    SOLVE_LIMIT,
+    SOLVE_TIMEOUT,
+    SOLVE_CANCELLED
+} SolveStatus;
+
+/**
+ * Outcome of puzzle_deduce: the hardest rule needed to fill the grid, from
+ * the simplest to the hardest, or why the grid was not filled.
+ */
+typedef enum DeductionGrade {
+    // The rules found a contradiction
+    GRADE_UNSAT = -1,
+    // The rules stopped ruling out values before the grid was full
+    GRADE_STALLED,
+    // A cell left with a single possible value takes it
+    GRADE_SINGLES,
+    // A cell is smaller than the largest value left in each greater cell,
+    // and greater than the smallest left in each smaller cell
+    GRADE_BOUNDS,
+    // A value left in a single cell of a row or column goes there
+    GRADE_HIDDEN,
+    // The cells a cell is transitively smaller than that share a row or
+    // column hold distinct values, all of them greater than it; likewise
+    // for the smaller ones
+    GRADE_CHAINS
+} DeductionGrade;
+
+/**
+ * Estimated size of a search, see puzzle_estimate.
+ */
+typedef struct SearchEstimate {
+    // Estimated number of nodes of the search tree
+    double nodes;
+
+    // Standard error of the estimate, as a fraction of it
+    double error;
+
+    // Random paths taken, and how many of them ended in a solution
+    unsigned int probes;
+    unsigned int solutions;
+} SearchEstimate;
+
+/**
+ * Returns the configuration given by OPT_LEVEL.
+ */
+SolverConfig solverconfig_default(void);
+
+/**
+ * Returns the default options: default configuration, ASSIGN_MAX
+ * assignments, no deadline, no cancellation flag, no statistics, no
+ * trace, no transposition table and no checkpoints.
+ */
+SolveOptions solveoptions_default(void);
+
+/**
+ * Returns the current time of a monotonic clock, in nanoseconds.
+ */
+uint64_t futoshiki_now(void);
+
+/**
+ * An inequality between two cells: the cell at (r1, c1) must be smaller
+ * than the one at (r2, c2). Coordinates start at 0.
+ */
+typedef struct PuzzleConstr {
+    unsigned char r1, c1;
+    unsigned char r2, c2;
+} PuzzleConstr;
 
 /**
  * Creates a new puzzle given the input stream.
+ * Returns NULL if the stream ends or holds an invalid puzzle.
  */
 Puzzle *puzzle_new(FILE *);
 
+/**
+ * Creates a new puzzle from a size x size grid stored row by row, with 0 for
+ * empty cells, and the given inequalities.
+ * Returns NULL if any value or coordinate is out of range.
+ */
+Puzzle *puzzle_fromGrid(unsigned char, const unsigned char *, size_t, const PuzzleConstr *);
+
+/**
+ * Creates a new puzzle from a buffer in the same text format read by
+ * puzzle_new. If not NULL, the last argument receives the number of bytes
+ * read, so that several puzzles can be parsed from the same buffer.
+ * Returns NULL if the buffer ends or holds an invalid puzzle.
+ */
+Puzzle *puzzle_parse(const char *, size_t, size_t *);
+
+/**
+ * Returns the length of the first complete puzzle in a buffer holding the
+ * text format read by puzzle_new, 0 if more data is needed, or -1 if the
+ * text is malformed. If the last argument is true, the buffer holds all the
+ * remaining data and the last number needs no separator after it.
+ */
+long puzzle_textLength(const char *, size_t, bool);
+
+/**
+ * Same as puzzle_parse, but recycles the memory of the given Puzzle (may be
+ * NULL) when the parsed puzzle has the same size. The given Puzzle is owned
+ * by this call: it is either returned or destroyed.
+ */
+Puzzle *puzzle_parseInto(Puzzle *, const char *, size_t, size_t *);
+
+/**
+ * Creates an independent copy of the Puzzle, in its current state.
+ */
+Puzzle *puzzle_clone(const Puzzle *);
+
 /**
  * Frees any memory associated with the Puzzle.
  */
@@ -26,11 +232,123 @@ void puzzle_destroy(Puzzle *);
 
 
 /**
- * Solves the given Puzzle.
- * Retruns wether or not the puzzle has a solution.
- * If not, the state of the cells are not changed.
+ * Solves the given Puzzle within the limits of the options (NULL for the
+ * defaults), adding the number of assignments made to the given counter.
+ * Returns whether the puzzle was solved, proven unsatisfiable or the reason
+ * the search was given up.
+ */
+SolveStatus puzzle_solve(Puzzle *, const SolveOptions *, int64_t *);
+
+/**
+ * Counts the solutions of the Puzzle within the limits of the options (NULL
+ * for the defaults), adding the number of assignments made to the given
+ * counter. With symmetry breaking, each solution found is counted along
+ * with every symmetric copy of it. Returns SOLVE_SOLVED or SOLVE_UNSAT if
+ * the count is complete, or the reason the search was given up, in which
+ * case the count is a lower bound. Either way the values of the Puzzle are
+ * kept.
+ */
+SolveStatus puzzle_count(Puzzle *, const SolveOptions *, uint64_t *, int64_t *);
+
+/**
+ * Races differently configured copies of the Puzzle on the given number of
+ * threads, starting from the configuration in the options. The first
+ * thread to finish publishes its result and the other threads are
+ * cancelled. The assignments and statistics of the deciding thread are
+ * reported; only the thread using the given configuration is traced.
+ */
+SolveStatus puzzle_solvePortfolio(Puzzle *, const SolveOptions *, int, int64_t *);
+
+/**
+ * Divides the search tree of the Puzzle among the given number of threads.
+ * Nodes are queued as snapshots (see core/snapshot.h); each thread takes
+ * one, restores it into its own copy of the Puzzle and either queues its
+ * children, while few nodes are queued, or searches it in full. The first
+ * solution found ends the search, so it may differ from the one found by
+ * puzzle_solve. The assignment limit applies to each thread, and the
+ * assignments of all of them are reported. Statistics and traces are not
+ * kept.
+ */
+SolveStatus puzzle_solveSplit(Puzzle *, const SolveOptions *, int, int64_t *);
+
+/**
+ * Solves <count> puzzles, writing the outcome of each into the array of
+ * statuses and adding its assignments to the matching counter. Runs of
+ * consecutive puzzles of the same size, up to 16 x 16, are propagated and
+ * searched together, eight at a time with AVX2 where available, and a
+ * puzzle that needs too many levels of branching is handed to puzzle_solve
+ * with the given options (NULL for the defaults). The lockstep search
+ * honours the same deadline, cancellation flag and assignment limit,
+ * checking the first two at every level: a puzzle left undecided when it
+ * stops gets SOLVE_TIMEOUT, SOLVE_CANCELLED or SOLVE_LIMIT, and one handed
+ * to puzzle_solve keeps the assignments already made. Returns the number
+ * of puzzles solved.
+ */
+size_t puzzle_solveBatch(Puzzle **, size_t, const SolveOptions *, SolveStatus *, int64_t *);
+
+/**
+ * Estimates the number of nodes puzzle_count would visit on the Puzzle with
+ * the given options (NULL for the defaults) by Knuth's method: each probe
+ * follows a random path down from the root, with the cell ordering,
+ * propagation and probing of the search, and multiplies the number of
+ * children of the nodes along it. A search that stops at the first solution
+ * usually visits fewer nodes. Takes up to the given number of paths, but
+ * no more once ESTIMATE_BUDGET assignments are spent, and leaves the Puzzle
+ * as it was. Estimates nothing for a puzzle known to have no solution.
+ */
+SearchEstimate puzzle_estimate(Puzzle *, const SolveOptions *, unsigned int);
+
+/**
+ * Fills the Puzzle by deduction alone, without guessing. Starting from the
+ * given values, applies the simplest of the rules of DeductionGrade that
+ * still rules out some value, going back to the simplest after each step,
+ * until the grid is full or no rule applies. Returns the hardest rule that
+ * was needed to fill the grid, or why it was not filled. Unless it finds a
+ * contradiction, stores the deduced values in the Puzzle, so a search
+ * started after a stall only decides the remaining cells.
+ */
+DeductionGrade puzzle_deduce(Puzzle *);
+
+/**
+ * Solves the Puzzle by local search instead of backtracking, for grids too
+ * large to search exhaustively. Each row starts as a random permutation of
+ * the values missing from it, and a conflicting cell repeatedly swaps values
+ * with the cell of its row that best reduces the number of repeated values
+ * in columns plus broken inequalities. A swap that made the grid worse is
+ * not undone right away, some swaps are random, and the grid is refilled
+ * when progress stalls.
+ * Each swap counts as two assignments. A solution is checked before it is
+ * stored in the Puzzle. Unsolvable puzzles are only detected if the given
+ * cells contradict each other; otherwise the search stops at the limits of
+ * the options (NULL for the defaults). Uses the seed of the configuration
+ * and ignores the other heuristics, the statistics and the trace.
+ */
+SolveStatus puzzle_solveLocal(Puzzle *, const SolveOptions *, int64_t *);
+
+/**
+ * Checks <count> grids of size x size values, stored row by row one after
+ * the other, as solutions of the Puzzle: each must be a latin square that
+ * keeps the current values of the Puzzle and satisfies its inequalities.
+ * Writes whether each grid is valid into the array and returns the number
+ * of valid grids. Uses AVX2, where available, for puzzles up to 32 x 32.
+ */
+size_t puzzle_verifyBatch(const Puzzle *, const unsigned char *, size_t, bool *);
+
+/**
+ * Returns the number of cells on each side of the Puzzle.
+ */
+unsigned char puzzle_getSize(const Puzzle *);
+
+/**
+ * Copies the current values of the Puzzle, row by row, into an array of
+ * size x size elements.
+ */
+void puzzle_getValues(const Puzzle *, unsigned char *);
+
+/**
+ * Returns a short lowercase name of the status ("solved", "unsat", ...).
  */
-bool puzzle_solve(Puzzle *, int *);
+const char *solvestatus_name(SolveStatus);
 
 /**
  * Displays the Puzzle to the given output stream.
@@ -0,0 +1,106 @@
+/*
+ * Template of the search kernels for a single grid size, included by
+ * src/core/kernels.c once per size with KERNEL_N defined. Every loop bound
+ * is then a constant, so the compiler can fully unroll the peer updates and
+ * the scans over the grid. The code mirrors the generic versions in
+ * src/core/futoshiki.c, which are used for the other sizes.
+ *
+ * Having no include guard is intentional.
+ */
+
+#ifndef KERNEL_N
+#error "KERNEL_N must be defined before including core/kernel.h"
+#endif
+
+#define _KERNEL_CAT(name, n) name##n
+#define _KERNEL_NAME(name, n) _KERNEL_CAT(name, n)
+#define KFN(name) _KERNEL_NAME(name, KERNEL_N)
+
+void KFN(_kernelStrengthen)(Puzzle *p, uchar row, uchar col, uchar val) {
+    Cell *other;
+    uchar i;
+
+#pragma GCC unroll 16
+    for (i = 0; i < KERNEL_N; i++) {
+        if (i != col) {
+            other = p->cells[row][i];
+            if (other->restrictedValues[val-1]++ == 0)
+                other->nPossibilities--;
+        }
+        if (i != row) {
+            other = p->cells[i][col];
+            if (other->restrictedValues[val-1]++ == 0)
+                other->nPossibilities--;
+        }
+    }
+}
+
+void KFN(_kernelLessen)(Puzzle *p, uchar row, uchar col, uchar val) {
+    Cell *other;
+    uchar i;
+
+#pragma GCC unroll 16
+    for (i = 0; i < KERNEL_N; i++) {
+        if (i != col) {
+            other = p->cells[row][i];
+            if (--other->restrictedValues[val-1] == 0)
+                other->nPossibilities++;
+        }
+        if (i != row) {
+            other = p->cells[i][col];
+            if (--other->restrictedValues[val-1] == 0)
+                other->nPossibilities++;
+        }
+    }
+}
+
+void KFN(_kernelUpdate)(Puzzle *p, Cell *c, uchar newVal) {
+    if (c->val > 0)
+        KFN(_kernelLessen)(p, c->row, c->col, c->val);
+    if (newVal > 0)
+        KFN(_kernelStrengthen)(p, c->row, c->col, newVal);
+}
+
+bool KFN(_kernelFeasible)(Puzzle *p) {
+    Cell *c;
+    uchar i, j;
+
+    for (i = 0; i < KERNEL_N; i++) {
+#pragma GCC unroll 16
+        for (j = 0; j < KERNEL_N; j++) {
+            c = p->cells[i][j];
+            if (c->val == 0 && c->nPossibilities == 0)
+                return false;
+        }
+    }
+    return true;
+}
+
+Cell *KFN(_kernelMostConstrained)(Puzzle *p) {
+    Cell *easiest = NULL, *c;
+    uchar easiestComplexity = UCHAR_MAX;
+    uchar i, j;
+
+    for (i = 0; i < KERNEL_N; i++) {
+#pragma GCC unroll 16
+        for (j = 0; j < KERNEL_N; j++) {
+            c = p->cells[i][j];
+            if (c->val == 0 && c->nPossibilities < easiestComplexity) {
+                easiest = c;
+                easiestComplexity = c->nPossibilities;
+            }
+        }
+    }
+    return easiest;
+}
+
+const SearchKernel KFN(searchKernel) = {
+    KFN(_kernelUpdate),
+    KFN(_kernelFeasible),
+    KFN(_kernelMostConstrained)
+};
+
+#undef KFN
+#undef _KERNEL_NAME
+#undef _KERNEL_CAT
+#undef KERNEL_N
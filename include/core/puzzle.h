@@ -0,0 +1,276 @@
+#pragma once
+
+#ifndef _PUZZLE_H_
+#define _PUZZLE_H_ 1
+
+/*
+ * Internal representation of a Puzzle, shared between the solver modules
+ * in src/core. Code outside of the core should only use core/futoshiki.h.
+ */
+
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#include "core/futoshiki.h"
+#include "core/stats.h"
+#include "core/trace.h"
+#include "core/symmetry.h"
+
+typedef unsigned char uchar;
+
+typedef struct Cell {
+    // Valor atual da célula
+    uchar val;
+
+    // Posição da célula na grade
+    uchar row;
+    uchar col;
+
+    // Células estritamente maiores e estritamente menores que esta, trechos
+    // dos vetores do grafo de desigualdades do tabuleiro
+    struct Cell **greater;
+    unsigned int nGreater;
+    struct Cell **smaller;
+    unsigned int nSmaller;
+
+    // Vetor onde cada posição i representa o número de células que impedem
+    // o valor i+1 de ser posto nesta célula.
+    // Mais adequado que um vetor de valores booleanos pois permite subtrair
+    // 1 do valor na volta do backtracking e somar 1 ao prosseguir à próxima
+    // célula.
+    uchar *restrictedValues;
+
+    // Número de valores que podem ser colocados nesta célula.
+    // Equivalente ao número de valores 0 em restrictedValues.
+    uchar nPossibilities;
+
+    // Posição de val na ordem de valores da busca atual
+    uchar orderPos;
+
+} Cell;
+
+struct Puzzle {
+    Cell ***cells;
+
+    // Número de células por lado do jogo
+    uchar size;
+
+    // Valores dados na entrada, linha a linha, antes de qualquer
+    // simplificação
+    uchar *givens;
+
+    // Grafo das desigualdades em formato CSR: as células maiores que a de
+    // índice i (linha * size + coluna) são greater[greaterStart[i]] até
+    // greater[greaterStart[i + 1] - 1], e analogamente para as menores
+    size_t nConstr;
+    size_t *greaterStart;
+    struct Cell **greater;
+    size_t *smallerStart;
+    struct Cell **smaller;
+
+    // Simetrias do tabuleiro, detectadas ao carregá-lo
+    SymmetryGroup sym;
+
+    // Se a análise das desigualdades ao carregá-lo provou não haver solução
+    bool unsat;
+};
+
+/*
+ * Innermost loops of the search. Grids of the most common sizes get kernels
+ * specialized for their size (see core/kernel.h); the others use the
+ * generic functions below.
+ */
+typedef struct SearchKernel {
+    // Updates the restrictions of the peers of a cell about to get a new value
+    void (*update)(Puzzle *, Cell *, uchar);
+    // Whether every empty cell still has some possible value
+    bool (*feasible)(Puzzle *);
+    // Empty cell with the fewest possible values, the first one in row order
+    // on ties, or NULL if the grid is full
+    Cell *(*mostConstrained)(Puzzle *);
+} SearchKernel;
+
+/*
+ * State of a single backtracking search over a Puzzle.
+ */
+typedef struct Search {
+    Puzzle *p;
+    const SolveOptions *opts;
+    const SolverConfig *cfg;
+
+    // Flag set by another thread to abort the search (may be NULL)
+    const atomic_bool *stop;
+
+    int64_t *assignments;
+
+    // SOLVE_UNSAT while the search runs, or the reason it was interrupted
+    SolveStatus status;
+
+    // Nodes between checks of deadline and cancellation, at least 1, and
+    // nodes left until the next one
+    unsigned int checkInterval;
+    unsigned int untilCheck;
+
+    // Number of decisions above the current node
+    unsigned int depth;
+
+    SolveStats *stats;
+    Trace *trace;
+
+    const SearchKernel *kernel;
+
+    // Table of unsolvable grids (may be NULL) and Zobrist hash of the
+    // current grid, kept only while there is a table
+    TransTable *table;
+    uint64_t hash;
+
+    // Cells filled in by the probe being tested
+    struct Cell **probeStack;
+
+    // Values ruled out by probing along the current path, undone when the
+    // search leaves the node that ruled them out
+    struct Cell **removedCells;
+    uchar *removedVals;
+    size_t nRemoved;
+    size_t removedCap;
+
+    // Order in which values are tried, a permutation of 1..size
+    uchar *valueOrder;
+
+    // Whether every solution is counted instead of stopping at the first
+    bool counting;
+    uint64_t solutions;
+
+    // Cell decided at each depth above the current node
+    struct Cell **path;
+
+    // Fingerprint of the puzzle as given and point of futoshiki_now() at
+    // which the state is saved next, kept only while checkpointing
+    uint64_t fingerprint;
+    uint64_t nextCheckpoint;
+
+    // Saved state whose decision path is being replayed, NULL once the
+    // search reaches the node where it was saved
+    const Checkpoint *resume;
+} Search;
+
+// Índice de uma célula na grade, linha a linha
+#define CELL_INDEX(p, c) ((size_t) (c)->row * (p)->size + (c)->col)
+
+#define TRACE(s, type, c, v) \
+    do { \
+        if ((s)->trace != NULL) \
+            trace_record((s)->trace, type, (s)->depth, (c)->row, (c)->col, v); \
+    } while (0)
+
+Cell *cell_new(Puzzle *, uchar, uchar, uchar);
+void cell_destroy(Cell *);
+
+void _updateRestrictedValues(Puzzle *, Cell *, uchar);
+bool _cellsFeasible(Puzzle *);
+bool _ineqViolated(Puzzle *);
+Cell *_mostConstrained(Puzzle *);
+
+/**
+ * Returns the search kernel specialized for the given grid size, or the
+ * generic one if there is none.
+ */
+const SearchKernel *searchkernel_get(uchar);
+uchar cell_smallestPossibility(Puzzle *, Cell *);
+uchar cell_greatestPossibility(Puzzle *, Cell *);
+
+/**
+ * Builds the inequality graph of the Puzzle from the given inequalities,
+ * replacing any previous one.
+ */
+void puzzle_buildGraph(Puzzle *, size_t, const PuzzleConstr *);
+void puzzle_simplify(Puzzle *);
+
+/**
+ * Bounds the values of every empty cell by the longest chains of
+ * inequalities above and below it, also through given cells, and rules
+ * out the values outside of the bounds. Must run before any value other
+ * than the givens is assigned. Returns false if the inequalities form a
+ * cycle or leave some cell without values, or if some given value repeats
+ * in a row or column, in which case the puzzle has no solution.
+ */
+bool puzzle_analyzeChains(Puzzle *);
+bool puzzle_checkSolved(Puzzle *);
+
+/**
+ * Assigns the values of src to the cells of dst, keeping the restriction
+ * counters of dst consistent. Both puzzles must have the same size.
+ */
+void puzzle_copyValues(Puzzle *dst, const Puzzle *src);
+
+/**
+ * Probes every possible value of every empty cell, ruling out for the rest
+ * of the current node those whose assertion fails, until no more values
+ * are ruled out or the budget of the configuration runs out. Returns false
+ * if some cell is left without values.
+ */
+bool _probe(Search *);
+
+/**
+ * Restores the values ruled out by probing since the given length of the
+ * list of ruled out values.
+ */
+void _probe_undo(Search *, size_t);
+
+/**
+ * Prepares a search on the Puzzle with the given options, counting its
+ * assignments in the given counter and also stopping as soon as stop
+ * becomes true (may be NULL).
+ */
+void _search_init(Search *, Puzzle *, const SolveOptions *, const atomic_bool *stop, int64_t *);
+void _search_free(Search *);
+
+/**
+ * Selects the next cell to decide after c (NULL at the root), or returns
+ * NULL if the grid is full.
+ */
+Cell *cell_nextInSeq(Search *, Cell *);
+
+/**
+ * Assigns to the cell the next possible value after its current one,
+ * returning false and emptying it when there is none.
+ */
+bool cell_nextValue(Search *, Cell *);
+
+/**
+ * Assigns to the cell the first possible value from the given position of
+ * the value order on, as cell_nextValue does from the position after the
+ * current value.
+ */
+bool _cell_valueFrom(Search *, Cell *, uchar);
+
+/**
+ * Hash of the values and inequalities of the Puzzle, identifying it in a
+ * checkpoint.
+ */
+uint64_t _checkpoint_fingerprint(const Puzzle *);
+
+/**
+ * Prepares the search to replay the path of its saved state, restoring the
+ * transposition table. Cancels the search if the state was saved by a
+ * search of another puzzle or with another configuration.
+ */
+void _checkpoint_begin(Search *);
+
+/**
+ * Assigns to the cell the value it had at the current depth of the saved
+ * path, ending the replay at the last one.
+ */
+bool _checkpoint_replay(Search *, Cell *);
+
+/**
+ * Saves the state of the search to the checkpoint file of its options.
+ */
+void _checkpoint_write(Search *);
+
+/**
+ * Runs a search on the Puzzle, also aborting as soon as stop becomes true.
+ */
+SolveStatus _solve(Puzzle *, const SolveOptions *, const atomic_bool *stop, int64_t *);
+
+#endif /* ifndef _PUZZLE_H_ */
@@ -0,0 +1,78 @@
+#pragma once
+
+#ifndef _SESSION_H_
+#define _SESSION_H_ 1
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "core/futoshiki.h"
+
+/*
+ * Incremental solving for interactive play. A session holds the givens of
+ * a puzzle and the entries of a player, keeping the restriction counters
+ * and the empty cells grouped by their number of possible values up to date
+ * on every move, in time linear in the size, and remembers the last
+ * solution found. As long as that solution agrees with every entry, asking
+ * whether the position is still solvable takes constant time, and asking
+ * for a hint time linear in the size; otherwise the position is searched
+ * again, starting from the counters already kept.
+ */
+
+typedef struct Session Session;
+
+/**
+ * Starts a session on a size x size grid of givens, stored row by row with
+ * 0 for empty cells, and the given inequalities. Searches use the options
+ * (NULL for the defaults), except for their deadline and symmetry
+ * breaking, since the entries of the player break the symmetries of the
+ * puzzle. Returns NULL if any value or coordinate is out of range.
+ */
+Session *session_new(unsigned char, const unsigned char *, size_t, const PuzzleConstr *, const SolveOptions *);
+void session_destroy(Session *);
+
+/**
+ * Places a value from 1 to size on a cell, replacing any previous entry.
+ * Returns false, changing nothing, if the cell or value is out of range or
+ * the cell is a given.
+ */
+bool session_set(Session *, unsigned char row, unsigned char col, unsigned char val);
+
+/**
+ * Erases the entry of a cell. Returns false if the cell is out of range or
+ * is a given.
+ */
+bool session_clear(Session *, unsigned char row, unsigned char col);
+
+/**
+ * Returns the given or entry of a cell, 0 if empty.
+ */
+unsigned char session_get(const Session *, unsigned char row, unsigned char col);
+
+/**
+ * Whether the givens and entries can still be completed into a solution:
+ * SOLVE_SOLVED if so, SOLVE_UNSAT if not, or the reason the search was
+ * given up.
+ */
+SolveStatus session_status(Session *);
+
+/**
+ * Suggests an empty cell, one with the fewest possible values, and its
+ * value in a solution that keeps every entry. Returns false if there is no
+ * such solution or no empty cell.
+ */
+bool session_hint(Session *, unsigned char *row, unsigned char *col, unsigned char *val);
+
+/**
+ * Copies a solution that keeps every entry, row by row, into an array of
+ * size x size elements. Returns false if there is none.
+ */
+bool session_getSolution(Session *, unsigned char *);
+
+/**
+ * Number of assignments made by every search of the session so far.
+ */
+int64_t session_assignments(const Session *);
+
+#endif /* ifndef _SESSION_H_ */
@@ -0,0 +1,67 @@
+#pragma once
+
+#ifndef _SNAPSHOT_H_
+#define _SNAPSHOT_H_ 1
+
+#include <stddef.h>
+
+#include "core/futoshiki.h"
+
+/*
+ * Compact copy of a search node: the value of every cell and the values
+ * ruled out of each empty cell by anything other than the values in its
+ * row and column, that is, by the inequalities and by probing. The rest of
+ * the restriction counters follows from the values and is rebuilt when the
+ * snapshot is restored. A snapshot is a flat array of bytes without
+ * pointers, so it can be copied with memcpy, queued, or handed to another
+ * thread and restored there into any Puzzle built from the same givens
+ * and inequalities. A 9 x 9 node takes 244 bytes.
+ */
+
+typedef struct SnapshotPool SnapshotPool;
+
+/**
+ * Number of bytes of a snapshot of a size x size Puzzle.
+ */
+size_t snapshot_size(unsigned char);
+
+/**
+ * Writes a snapshot of the current state of the Puzzle into the buffer,
+ * which must hold snapshot_size bytes, using the scratch space of a pool
+ * of the same size.
+ */
+void puzzle_saveSnapshot(const Puzzle *, void *, SnapshotPool *);
+
+/**
+ * Replaces the values and restrictions of the Puzzle with those of the
+ * snapshot, which must come from a Puzzle of the same size, givens and
+ * inequalities, using the scratch space of a pool of the same size.
+ */
+void puzzle_restoreSnapshot(Puzzle *, const void *, SnapshotPool *);
+
+/**
+ * Creates a pool of snapshot buffers for size x size puzzles, along with
+ * the scratch space taken by saving and restoring, so that neither
+ * allocates. A pool must only be used by one thread at a time, but a
+ * buffer taken from one pool may be released to any other pool of the
+ * same size, so a branch can move to another thread along with its
+ * buffer.
+ */
+SnapshotPool *snapshotpool_new(unsigned char);
+
+/**
+ * Frees the pool and every buffer released to it.
+ */
+void snapshotpool_destroy(SnapshotPool *);
+
+/**
+ * Takes a buffer from the pool, allocating it only if the pool is empty.
+ */
+void *snapshotpool_get(SnapshotPool *);
+
+/**
+ * Returns a buffer to the pool for reuse.
+ */
+void snapshotpool_put(SnapshotPool *, void *);
+
+#endif /* ifndef _SNAPSHOT_H_ */
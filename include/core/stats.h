@@ -0,0 +1,123 @@
+#pragma once
+
+#ifndef _STATS_H_
+#define _STATS_H_ 1
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "core/futoshiki.h"
+
+/*
+ * Counters collected by a search when the solver is compiled with
+ * FUTOSHIKI_STATS (make stats=1). Compiled with FUTOSHIKI_TIMERS as well
+ * (make timers=1), the time spent in each phase is also measured, in TSC
+ * cycles where available and nanoseconds otherwise. Without these flags
+ * none of the instrumentation is compiled in.
+ */
+
+// Depths beyond this one are accounted in the last histogram entry
+#define STATS_MAX_DEPTH 128
+
+typedef enum StatsPhase {
+    PHASE_FORWARD_CHECK,
+    PHASE_INEQ_CHECK,
+    PHASE_SELECT,
+    PHASE_LEAF_CHECK,
+    PHASE_COUNT
+} StatsPhase;
+
+struct SolveStats {
+    uint64_t nodes;
+    uint64_t backtracks;
+    unsigned int maxDepth;
+
+    // Propagation work
+    uint64_t forwardChecks;
+    uint64_t ineqChecks;
+    uint64_t leafChecks;
+    uint64_t probes;
+    uint64_t probeRemovals;
+
+    // Failures, by the kind of constraint that caused them
+    uint64_t rowColWipeouts;
+    uint64_t ineqWipeouts;
+    uint64_t leafFailures;
+
+    // Nodes cut for holding only copies of other solutions
+    uint64_t symmetryPrunes;
+
+    // Nodes cut for holding a grid already proven unsolvable
+    uint64_t transpositionHits;
+
+    // Nodes and children explored at each depth
+    uint64_t depthNodes[STATS_MAX_DEPTH];
+    uint64_t depthChildren[STATS_MAX_DEPTH];
+
+    uint64_t phaseTime[PHASE_COUNT];
+};
+
+/**
+ * Zeroes every counter.
+ */
+void solvestats_clear(SolveStats *);
+
+/**
+ * Writes the counters to the stream as a single-line JSON object.
+ */
+void solvestats_printJson(const SolveStats *, FILE *);
+
+#ifdef FUTOSHIKI_STATS
+
+#define STATS_INC(s, field) \
+    do { if ((s)->stats != NULL) (s)->stats->field++; } while (0)
+
+#define STATS_NODE(s) \
+    do { \
+        if ((s)->stats != NULL) { \
+            unsigned int _d = (s)->depth < STATS_MAX_DEPTH ? (s)->depth : STATS_MAX_DEPTH - 1; \
+            (s)->stats->nodes++; \
+            (s)->stats->depthNodes[_d]++; \
+            if ((s)->depth > (s)->stats->maxDepth) \
+                (s)->stats->maxDepth = (s)->depth; \
+        } \
+    } while (0)
+
+#define STATS_CHILD(s) \
+    do { \
+        if ((s)->stats != NULL) \
+            (s)->stats->depthChildren[(s)->depth < STATS_MAX_DEPTH ? (s)->depth : STATS_MAX_DEPTH - 1]++; \
+    } while (0)
+
+#else
+
+#define STATS_INC(s, field) ((void) 0)
+#define STATS_NODE(s) ((void) 0)
+#define STATS_CHILD(s) ((void) 0)
+
+#endif /* ifdef FUTOSHIKI_STATS */
+
+#if defined(FUTOSHIKI_STATS) && defined(FUTOSHIKI_TIMERS)
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define _stats_clock() __rdtsc()
+#else
+#define _stats_clock() futoshiki_now()
+#endif
+
+#define TIMER_START(t) uint64_t t = _stats_clock()
+#define TIMER_STOP(s, phase, t) \
+    do { \
+        if ((s)->stats != NULL) \
+            (s)->stats->phaseTime[phase] += _stats_clock() - (t); \
+    } while (0)
+
+#else
+
+#define TIMER_START(t) ((void) 0)
+#define TIMER_STOP(s, phase, t) ((void) 0)
+
+#endif
+
+#endif /* ifndef _STATS_H_ */
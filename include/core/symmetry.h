@@ -0,0 +1,89 @@
+#pragma once
+
+#ifndef _SYMMETRY_H_
+#define _SYMMETRY_H_ 1
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+
+#include "core/futoshiki.h"
+
+/*
+ * Transformations that map a Futoshiki puzzle into an equivalent one: the 8
+ * symmetries of the square (rotations, reflections and transposition), each
+ * optionally combined with the value flip v -> size + 1 - v, which reverses
+ * every inequality. Transform 0 is the identity and transforms below
+ * SYMMETRY_DIHEDRAL keep the values.
+ */
+
+#define SYMMETRY_DIHEDRAL 8
+#define SYMMETRY_COUNT 16
+
+/*
+ * Symmetries of a loaded puzzle: the transforms that map it to itself and,
+ * for puzzles without inequalities, the values absent from the grid, which
+ * may be freely permuted. Together they generate a group that maps every
+ * solution to another solution.
+ */
+typedef struct SymmetryGroup {
+    // Transformações, exceto a identidade, que levam o tabuleiro a si mesmo
+    unsigned char nAuto;
+    unsigned char autos[SYMMETRY_COUNT];
+
+    // Valores intercambiáveis, em ordem crescente
+    unsigned char nInterch;
+    unsigned char interch[UCHAR_MAX];
+} SymmetryGroup;
+
+/**
+ * Position that the cell at (row, col) takes under the transform.
+ */
+void symmetry_mapCell(int, unsigned char size, unsigned char row, unsigned char col,
+        unsigned char *, unsigned char *);
+
+/**
+ * Value that v takes under the transform (0, an empty cell, is kept).
+ */
+unsigned char symmetry_mapValue(int, unsigned char size, unsigned char v);
+
+/**
+ * Number of bytes needed to encode the Puzzle.
+ */
+size_t symmetry_keyLength(const Puzzle *);
+
+/**
+ * Encodes the current values and the inequalities of the Puzzle, as seen
+ * through the transform, into symmetry_keyLength bytes. Two puzzles have
+ * the same encoding exactly when they have the same values and the same
+ * inequalities.
+ */
+void symmetry_encode(const Puzzle *, int, unsigned char *);
+
+/**
+ * Writes the smallest encoding among all transforms of the Puzzle, which is
+ * shared by every puzzle equivalent to it, and returns the transform that
+ * produced it.
+ */
+int symmetry_canonical(const Puzzle *, unsigned char *);
+
+/**
+ * Finds the symmetries of the Puzzle in its current state.
+ */
+void symmetry_detect(const Puzzle *, SymmetryGroup *);
+
+/**
+ * Returns false if the values assigned so far already prevent the grid from
+ * being the lexicographically smallest (row by row) of its orbit, so that
+ * searching below the current node only finds copies of other solutions.
+ */
+bool symmetry_allowed(const Puzzle *, const SymmetryGroup *);
+
+/**
+ * For a filled grid, returns the size of its orbit if it is the smallest of
+ * the orbit, or 0 otherwise. Sizes beyond UINT64_MAX are saturated.
+ */
+uint64_t symmetry_orbit(const Puzzle *, const SymmetryGroup *);
+
+#endif /* ifndef _SYMMETRY_H_ */
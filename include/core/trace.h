@@ -0,0 +1,79 @@
+#pragma once
+
+#ifndef _TRACE_H_
+#define _TRACE_H_ 1
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Ring buffer of search events. When full, the oldest events are
+ * overwritten. Attach one to SolveOptions::trace to record a search.
+ */
+
+typedef enum TraceEventType {
+    // A value was tentatively assigned to a cell
+    TRACE_DECIDE,
+    // The assignment passed forward checking
+    TRACE_PROPAGATE,
+    // The assignment left some cell or inequality without options
+    TRACE_WIPEOUT,
+    // Every value of the cell was tried; the cell is empty again
+    TRACE_BACKTRACK,
+    // The grid was filled and checked
+    TRACE_SOLUTION,
+    TRACE_LEAF_FAIL
+} TraceEventType;
+
+typedef struct TraceEvent {
+    uint64_t time;
+    uint16_t depth;
+    uint8_t type;
+    uint8_t row;
+    uint8_t col;
+    uint8_t val;
+    uint8_t pad[2];
+} TraceEvent;
+
+typedef struct Trace Trace;
+
+/**
+ * Creates a trace holding the last <capacity> events (rounded up to a
+ * power of two).
+ */
+Trace *trace_new(size_t);
+void trace_destroy(Trace *);
+
+/**
+ * Discards every event and restarts the clock of the trace.
+ */
+void trace_clear(Trace *);
+
+void trace_record(Trace *, TraceEventType, unsigned int, uint8_t, uint8_t, uint8_t);
+
+/**
+ * Number of events currently held, and number of events overwritten.
+ */
+size_t trace_length(const Trace *);
+uint64_t trace_dropped(const Trace *);
+
+/**
+ * Returns the i-th oldest event held.
+ */
+const TraceEvent *trace_get(const Trace *, size_t);
+
+/**
+ * Writes the events as Chrome trace-event objects, each one preceded by a
+ * comma, to be placed inside a "traceEvents" array. Each decision is a
+ * duration event named after its cell and value; pid identifies the search.
+ */
+void trace_exportChrome(const Trace *, FILE *, int pid);
+
+/**
+ * Writes the decisions as folded stacks ("root;r1c2;r3c1 count"), one line
+ * per distinct path of cells, as read by flamegraph.pl and speedscope.
+ */
+void trace_exportFolded(const Trace *, FILE *, const char *root);
+
+#endif /* ifndef _TRACE_H_ */
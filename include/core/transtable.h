@@ -0,0 +1,53 @@
+#pragma once
+
+#ifndef _TRANSTABLE_H_
+#define _TRANSTABLE_H_ 1
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "core/futoshiki.h"
+
+/*
+ * Bounded table of the Zobrist hashes of grids proven to have no solution,
+ * attached to SolveOptions::transpositions. Before expanding a node, a
+ * search looks its grid up and gives up on it if found; every subtree
+ * searched in full without a solution is added. Entries are only valid for
+ * the puzzle they were found on, and for searches that agree on symmetry
+ * breaking, so the table must be cleared before solving another puzzle.
+ * It may be shared by any number of threads
+ * searching the same puzzle: entries are read and written atomically,
+ * without locks, and when full a bucket simply loses an old entry.
+ * Searches that count solutions neither read nor fill the table.
+ */
+
+/**
+ * Creates a table holding up to <capacity> grids (rounded up to a power of
+ * two).
+ */
+TransTable *transtable_new(size_t);
+void transtable_destroy(TransTable *);
+
+/**
+ * Discards every entry. Must not run concurrently with a search.
+ */
+void transtable_clear(TransTable *);
+
+bool transtable_contains(const TransTable *, uint64_t);
+void transtable_insert(TransTable *, uint64_t);
+
+/**
+ * Maximum number of grids held by the table.
+ */
+size_t transtable_capacity(const TransTable *);
+
+/**
+ * Copies the hashes held by the table to the array, which must have room
+ * for transtable_capacity of them, and returns how many were copied.
+ * Inserting them in the same order into a cleared table of the same
+ * capacity rebuilds this one exactly.
+ */
+size_t transtable_entries(const TransTable *, uint64_t *);
+
+#endif /* ifndef _TRANSTABLE_H_ */
@@ -0,0 +1,45 @@
+#pragma once
+
+#ifndef _SERVER_H_
+#define _SERVER_H_ 1
+
+#include <stdatomic.h>
+
+#include "core/futoshiki.h"
+#include "core/cache.h"
+
+/*
+ * Solver daemon listening on a Unix domain socket.
+ *
+ * A client writes any number of puzzles to its connection, back to back in
+ * the same text format read by puzzle_new, without waiting for the answers.
+ * Each puzzle is numbered from 0 in the order it was sent on the connection
+ * and, once solved, answered with
+ *
+ *     <number> <status> <microseconds> <assignments>
+ *
+ * followed by the rows of the grid when the status is "solved". Status is
+ * one of the names given by solvestatus_name, or "invalid" for a puzzle with
+ * values out of range. Text that is not a sequence of numbers is answered
+ * with "invalid" and closes the connection. Answers are sent as soon as each
+ * puzzle is solved, so they may come out of order. Each connection has its
+ * own thread sending its answers, so the worker threads never wait for a
+ * client. Once a connection has a fixed number of puzzles whose answers
+ * were not yet sent, the server stops reading it until some of them are,
+ * so a client that does not read its answers stalls only itself instead of
+ * growing the queue without bound.
+ */
+
+/**
+ * Serves requests on a socket created at the given path with the given
+ * number of worker threads, until stop becomes true. Every search uses the
+ * given options (NULL for the defaults); timeout, if positive, is the
+ * maximum duration of each search in milliseconds. Puzzles equivalent to
+ * one already answered are served from the cache, if not NULL. When
+ * stopped, the puzzles already received are still answered, and clients
+ * get a few seconds to read the answers before their connections are
+ * closed. Returns 0 when stopped, or -1 if the socket could not be set up.
+ */
+int server_run(const char *, int, const SolveOptions *, long timeout, SolveCache *, const atomic_bool *stop);
+
+#endif /* ifndef _SERVER_H_ */
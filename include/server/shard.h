@@ -0,0 +1,53 @@
+#pragma once
+
+#ifndef _SHARD_H_
+#define _SHARD_H_ 1
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Runs a job over a numbered set of cases in forked worker processes.
+ *
+ * Case k goes to worker k % nWorkers, each worker pinned to its own CPU
+ * where the system allows it. A worker writes the output of each case to a
+ * pipe as soon as it is done, and the coordinator hands the outputs over in
+ * case order. A worker that dies, or that spends longer than the limit on a
+ * single case, is replaced by a new one starting at its next case, and the
+ * case it was on is reported as lost instead of taking the rest of its shard
+ * with it. If the coordinator can no longer wait on the pipes, it kills and
+ * reaps every worker, reports the cases they had left as lost and still
+ * hands over the outputs it already has.
+ */
+
+typedef enum ShardOutcome {
+    SHARD_OK,       // the job returned true
+    SHARD_FAILED,   // the job returned false
+    SHARD_CRASHED,  // the worker died during the case
+    SHARD_KILLED    // the worker exceeded the limit and was killed
+} ShardOutcome;
+
+/**
+ * Handles case k in a worker, writing its output to the given stream.
+ * Returns whether the case succeeded.
+ */
+typedef bool (*ShardJob)(size_t k, FILE *, void *);
+
+/**
+ * Receives, in the coordinator and in case order, the outcome of case k and
+ * the output written by its job, which is empty if the worker was lost.
+ */
+typedef void (*ShardEmit)(size_t k, ShardOutcome, const char *, size_t, void *);
+
+/**
+ * Runs job over cases 0 to nCases - 1 with the given number of workers,
+ * passing ctx to both callbacks. Worker state is a copy of the caller's at
+ * the time of the fork. limit, if positive, is the maximum duration of a
+ * case in milliseconds. Cases of a worker that cannot be forked are
+ * reported as SHARD_CRASHED.
+ * Returns the number of cases with outcome SHARD_OK.
+ */
+long shard_run(size_t nCases, int nWorkers, long limit, ShardJob job, ShardEmit emit, void *ctx);
+
+#endif /* ifndef _SHARD_H_ */
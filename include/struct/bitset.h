@@ -0,0 +1,69 @@
+#pragma once
+
+#ifndef _BITSET_H_
+#define _BITSET_H_ 1
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Set of the integers 0 to nBits - 1, stored in 64-bit words so that set
+ * operations, counting and scanning work a word at a time. Unlike
+ * BitArray, bit i is bit i % 64 of word i / 64. The binary operations
+ * require both sets to have the same number of bits.
+ */
+typedef struct BitSet BitSet;
+
+// Returned by bitset_first and bitset_next when there is no set bit
+#define BITSET_NONE ((size_t) -1)
+
+BitSet *bitset_new(size_t);
+void bitset_destroy(BitSet *);
+
+size_t bitset_getNBits(const BitSet *);
+
+bool bitset_check(const BitSet *, size_t);
+
+void bitset_set(BitSet *, size_t);
+void bitset_clear(BitSet *, size_t);
+void bitset_toggle(BitSet *, size_t);
+
+void bitset_setAll(BitSet *);
+void bitset_clearAll(BitSet *);
+void bitset_toggleAll(BitSet *);
+
+/**
+ * In-place operations on the first set: a = a & b, a | b, a & ~b, a ^ b
+ * and b.
+ */
+void bitset_and(BitSet *, const BitSet *);
+void bitset_or(BitSet *, const BitSet *);
+void bitset_andNot(BitSet *, const BitSet *);
+void bitset_xor(BitSet *, const BitSet *);
+void bitset_copy(BitSet *, const BitSet *);
+
+/**
+ * Number of set bits.
+ */
+size_t bitset_count(const BitSet *);
+
+/**
+ * Smallest set bit, or the smallest one not below the given bit.
+ */
+size_t bitset_first(const BitSet *);
+size_t bitset_next(const BitSet *, size_t);
+
+bool bitset_isEmpty(const BitSet *);
+bool bitset_equals(const BitSet *, const BitSet *);
+
+/**
+ * Whether every bit of the first set is in the second one.
+ */
+bool bitset_isSubset(const BitSet *, const BitSet *);
+
+/**
+ * Whether the sets have some bit in common.
+ */
+bool bitset_intersects(const BitSet *, const BitSet *);
+
+#endif /* ifndef _BITSET_H_ */
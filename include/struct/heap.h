@@ -23,4 +23,43 @@ void heap_updateIf(Heap *, bool (*) (const void *, void *), void *, void (*) (vo
 bool heap_isEmpty(const Heap *);
 size_t heap_getSize(const Heap *);
 
+/*
+ * Binary heap of the ids 0 to capacity - 1, each one with an integer
+ * priority, kept in an array along with the position of each id. The id
+ * with the smallest priority is on top, the smallest id first among equal
+ * priorities. Changing the priority of an id takes O(log n) and nothing is
+ * allocated after indexheap_new.
+ */
+typedef struct IndexHeap IndexHeap;
+
+// Returned by indexheap_pop and indexheap_peek when the heap is empty
+#define INDEXHEAP_NONE ((size_t) -1)
+
+IndexHeap *indexheap_new(size_t capacity);
+void indexheap_destroy(IndexHeap *);
+
+/**
+ * Removes every id from the heap.
+ */
+void indexheap_clear(IndexHeap *);
+
+/**
+ * Inserts the id with the given priority or, if it is already in the heap,
+ * changes its priority.
+ */
+void indexheap_push(IndexHeap *, size_t id, long priority);
+size_t indexheap_pop(IndexHeap *);
+size_t indexheap_peek(const IndexHeap *);
+
+/**
+ * Removes the id from the heap, if it is there.
+ */
+void indexheap_remove(IndexHeap *, size_t id);
+
+bool indexheap_contains(const IndexHeap *, size_t id);
+long indexheap_priority(const IndexHeap *, size_t id);
+
+bool indexheap_isEmpty(const IndexHeap *);
+size_t indexheap_getSize(const IndexHeap *);
+
 #endif /* ifndef _HEAP_H_ */
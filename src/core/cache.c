@@ -0,0 +1,240 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "core/cache.h"
+#include "core/futoshiki.h"
+#include "core/puzzle.h"
+#include "core/symmetry.h"
+
+#define CACHE_NONE ((size_t) -1)
+
+typedef struct CacheEntry {
+    // Forma canônica do tabuleiro
+    uchar *key;
+    size_t keyLen;
+    uint64_t hash;
+
+    SolveStatus status;
+
+    // Solução da forma canônica, linha a linha (se status == SOLVE_SOLVED)
+    uchar *solution;
+
+    // Usada desde a última passagem do ponteiro do relógio
+    bool referenced;
+
+    // Próxima entrada no mesmo balde
+    size_t next;
+} CacheEntry;
+
+struct SolveCache {
+    pthread_mutex_t lock;
+
+    CacheEntry *entries;
+    size_t capacity;
+    size_t length;
+
+    // Cabeças das listas de entradas por balde; mask + 1 baldes
+    size_t *buckets;
+    size_t mask;
+
+    // Próxima entrada candidata à remoção
+    size_t hand;
+
+    uint64_t hits;
+    uint64_t misses;
+};
+
+SolveCache *solvecache_new(size_t capacity) {
+    SolveCache *cache = malloc(sizeof(*cache));
+    size_t i, nBuckets = 1;
+
+    if (capacity < 1)
+        capacity = 1;
+    while (nBuckets < 2 * capacity)
+        nBuckets <<= 1;
+
+    pthread_mutex_init(&cache->lock, NULL);
+    cache->entries = malloc(capacity * sizeof(*cache->entries));
+    cache->capacity = capacity;
+    cache->length = 0;
+    cache->buckets = malloc(nBuckets * sizeof(*cache->buckets));
+    for (i = 0; i < nBuckets; i++)
+        cache->buckets[i] = CACHE_NONE;
+    cache->mask = nBuckets - 1;
+    cache->hand = 0;
+    cache->hits = 0;
+    cache->misses = 0;
+
+    return cache;
+}
+
+void solvecache_destroy(SolveCache *cache) {
+    size_t i;
+
+    for (i = 0; i < cache->length; i++) {
+        free(cache->entries[i].key);
+        free(cache->entries[i].solution);
+    }
+    free(cache->entries);
+    free(cache->buckets);
+    pthread_mutex_destroy(&cache->lock);
+    free(cache);
+}
+
+// FNV-1a de 64 bits
+uint64_t _cache_hash(const uchar *key, size_t len) {
+    uint64_t h = 14695981039346656037ULL;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        h ^= key[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+CacheEntry *_cache_find(SolveCache *cache, const uchar *key, size_t len, uint64_t hash) {
+    size_t i = cache->buckets[hash & cache->mask];
+    CacheEntry *e;
+
+    while (i != CACHE_NONE) {
+        e = &cache->entries[i];
+        if (e->hash == hash && e->keyLen == len && memcmp(e->key, key, len) == 0)
+            return e;
+        i = e->next;
+    }
+    return NULL;
+}
+
+// Retira a entrada i do seu balde
+void _cache_unlink(SolveCache *cache, size_t i) {
+    size_t *link = &cache->buckets[cache->entries[i].hash & cache->mask];
+
+    while (*link != i)
+        link = &cache->entries[*link].next;
+    *link = cache->entries[i].next;
+}
+
+// Escolhe a entrada a ser ocupada, removendo a primeira não usada desde a
+// última passagem do relógio quando o cache está cheio
+size_t _cache_slot(SolveCache *cache) {
+    size_t i;
+
+    if (cache->length < cache->capacity)
+        return cache->length++;
+
+    while (cache->entries[cache->hand].referenced) {
+        cache->entries[cache->hand].referenced = false;
+        cache->hand = (cache->hand + 1) % cache->capacity;
+    }
+    i = cache->hand;
+    cache->hand = (cache->hand + 1) % cache->capacity;
+
+    _cache_unlink(cache, i);
+    free(cache->entries[i].key);
+    free(cache->entries[i].solution);
+    return i;
+}
+
+void _cache_insert(SolveCache *cache, uchar *key, size_t len, uint64_t hash,
+        SolveStatus status, uchar *solution) {
+    CacheEntry *e;
+    size_t i;
+
+    // Outra thread pode ter resolvido o mesmo tabuleiro enquanto isso
+    if (_cache_find(cache, key, len, hash) != NULL) {
+        free(key);
+        free(solution);
+        return;
+    }
+
+    i = _cache_slot(cache);
+    e = &cache->entries[i];
+    e->key = key;
+    e->keyLen = len;
+    e->hash = hash;
+    e->status = status;
+    e->solution = solution;
+    e->referenced = false;
+    e->next = cache->buckets[hash & cache->mask];
+    cache->buckets[hash & cache->mask] = i;
+}
+
+// Atribui ao tabuleiro a solução da forma canônica obtida pela transformação t
+void _cache_apply(Puzzle *p, int t, const uchar *solution) {
+    uchar i, j, r, c, v;
+    Cell *cell;
+
+    for (i = 0; i < p->size; i++) {
+        for (j = 0; j < p->size; j++) {
+            symmetry_mapCell(t, p->size, i, j, &r, &c);
+            // A troca de valores é sua própria inversa
+            v = symmetry_mapValue(t, p->size, solution[r * p->size + c]);
+            cell = p->cells[i][j];
+            _updateRestrictedValues(p, cell, v);
+            cell->val = v;
+        }
+    }
+}
+
+// Solução do tabuleiro vista pela transformação t
+uchar *_cache_solution(const Puzzle *p, int t) {
+    uchar *solution = malloc((size_t) p->size * p->size);
+    uchar i, j, r, c;
+
+    for (i = 0; i < p->size; i++) {
+        for (j = 0; j < p->size; j++) {
+            symmetry_mapCell(t, p->size, i, j, &r, &c);
+            solution[r * p->size + c] = symmetry_mapValue(t, p->size, p->cells[i][j]->val);
+        }
+    }
+    return solution;
+}
+
+SolveStatus solvecache_solve(SolveCache *cache, Puzzle *p, const SolveOptions *opts,
+        int nThreads, int64_t *assignments) {
+    size_t len = symmetry_keyLength(p);
+    uchar *key = malloc(len);
+    int t = symmetry_canonical(p, key);
+    uint64_t hash = _cache_hash(key, len);
+    SolveStatus status;
+    CacheEntry *e;
+
+    pthread_mutex_lock(&cache->lock);
+    e = _cache_find(cache, key, len, hash);
+    if (e != NULL) {
+        e->referenced = true;
+        status = e->status;
+        if (status == SOLVE_SOLVED)
+            _cache_apply(p, t, e->solution);
+        cache->hits++;
+        pthread_mutex_unlock(&cache->lock);
+
+        free(key);
+        return status;
+    }
+    cache->misses++;
+    pthread_mutex_unlock(&cache->lock);
+
+    status = puzzle_solvePortfolio(p, opts, nThreads, assignments);
+    if (status != SOLVE_SOLVED && status != SOLVE_UNSAT) {
+        free(key);
+        return status;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+    _cache_insert(cache, key, len, hash, status,
+            status == SOLVE_SOLVED ? _cache_solution(p, t) : NULL);
+    pthread_mutex_unlock(&cache->lock);
+
+    return status;
+}
+
+void solvecache_counters(SolveCache *cache, uint64_t *hits, uint64_t *misses) {
+    pthread_mutex_lock(&cache->lock);
+    *hits = cache->hits;
+    *misses = cache->misses;
+    pthread_mutex_unlock(&cache->lock);
+}
@@ -0,0 +1,105 @@
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "core/puzzle.h"
+
+// Ordena as células de forma que toda célula venha antes das maiores que
+// ela. Retorna false se as desigualdades formarem um ciclo.
+bool _chains_sort(Puzzle *p, size_t *order) {
+    size_t n = (size_t) p->size * p->size;
+    size_t *inDegree = calloc(n, sizeof(*inDegree));
+    size_t head = 0, tail = 0, i;
+    unsigned int k;
+    Cell *c;
+
+    // O grau de entrada é o número de células menores
+    for (i = 0; i < n; i++) {
+        inDegree[i] = p->cells[i / p->size][i % p->size]->nSmaller;
+        if (inDegree[i] == 0)
+            order[tail++] = i;
+    }
+
+    // Algoritmo de Kahn
+    while (head < tail) {
+        c = p->cells[order[head] / p->size][order[head] % p->size];
+        head++;
+        for (k = 0; k < c->nGreater; k++) {
+            i = CELL_INDEX(p, c->greater[k]);
+            if (--inDegree[i] == 0)
+                order[tail++] = i;
+        }
+    }
+
+    free(inDegree);
+    return tail == n;
+}
+
+// Proíbe permanentemente os valores de c fora de [lo, hi], como
+// _updateIneqRestr. Retorna false se não restar valor algum.
+bool _chains_restrict(Puzzle *p, Cell *c, uchar lo, uchar hi) {
+    uchar j;
+
+    for (j = 0; j < p->size; j++) {
+        if (j + 1 >= lo && j + 1 <= hi)
+            continue;
+        if (c->restrictedValues[j] == 0)
+            c->nPossibilities--;
+        c->restrictedValues[j] = 1;
+    }
+    return c->nPossibilities > 0;
+}
+
+bool puzzle_analyzeChains(Puzzle *p) {
+    size_t n = (size_t) p->size * p->size;
+    size_t *order = malloc(n * sizeof(*order));
+    // Limites de cada célula, em int para não transbordar ao longo de
+    // cadeias maiores que o tabuleiro
+    int *lo = malloc(n * sizeof(*lo));
+    int *hi = malloc(n * sizeof(*hi));
+    bool feasible;
+    size_t i, t;
+    Cell *c;
+    unsigned int k;
+
+    feasible = _chains_sort(p, order);
+
+    for (i = 0; i < n && feasible; i++) {
+        c = p->cells[i / p->size][i % p->size];
+        lo[i] = c->val > 0 ? c->val : 1;
+        hi[i] = c->val > 0 ? c->val : p->size;
+    }
+
+    // Em ordem topológica, cada célula é maior que todas as anteriores na
+    // mesma cadeia; em ordem inversa, menor que todas as posteriores
+    for (t = 0; t < n && feasible; t++) {
+        c = p->cells[order[t] / p->size][order[t] % p->size];
+        for (k = 0; k < c->nGreater; k++) {
+            i = CELL_INDEX(p, c->greater[k]);
+            if (lo[i] < lo[order[t]] + 1)
+                lo[i] = lo[order[t]] + 1;
+        }
+    }
+    for (t = n; t > 0 && feasible; t--) {
+        c = p->cells[order[t - 1] / p->size][order[t - 1] % p->size];
+        for (k = 0; k < c->nGreater; k++) {
+            i = CELL_INDEX(p, c->greater[k]);
+            if (hi[order[t - 1]] > hi[i] - 1)
+                hi[order[t - 1]] = hi[i] - 1;
+        }
+    }
+
+    for (i = 0; i < n && feasible; i++) {
+        c = p->cells[i / p->size][i % p->size];
+        // Valores dados repetidos na mesma linha ou coluna restringem um ao
+        // outro
+        if (lo[i] > hi[i] || (c->val > 0 && c->restrictedValues[c->val - 1] > 0))
+            feasible = false;
+        else if (c->val == 0)
+            feasible = _chains_restrict(p, c, lo[i], hi[i]);
+    }
+
+    free(order);
+    free(lo);
+    free(hi);
+    return feasible;
+}
@@ -0,0 +1,229 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <string.h>
+
+#include "core/checkpoint.h"
+#include "core/puzzle.h"
+#include "core/transtable.h"
+
+#define CHECKPOINT_MAGIC "FTCK"
+#define CHECKPOINT_VERSION 1
+
+// Campos da configuração que alteram a ordem da busca
+#define CONFIG_FIELDS 8
+
+/*
+ * Início do arquivo, seguido de depth ternas (linha, coluna, posição na
+ * ordem de valores) do caminho de decisões e de nEntries hashes da tabela
+ * de transposição. Campos ordenados para não haver preenchimento.
+ */
+typedef struct CheckpointHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t tag;
+    uint64_t fingerprint;
+    uint64_t solutions;
+    int64_t assignments;
+    uint32_t config[CONFIG_FIELDS];
+    uint32_t counting;
+    uint32_t depth;
+    uint64_t nEntries;
+} CheckpointHeader;
+
+struct Checkpoint {
+    CheckpointHeader h;
+    uchar *path;
+    uint64_t *entries;
+};
+
+void _checkpoint_config(const SolverConfig *cfg, uint32_t *out) {
+    out[0] = cfg->forwardChecking;
+    out[1] = cfg->mvr;
+    out[2] = cfg->ineqCheck;
+    out[3] = cfg->symmetryBreaking;
+    out[4] = cfg->order;
+    out[5] = cfg->seed;
+    out[6] = cfg->probeDepth;
+    out[7] = cfg->probeBudget;
+}
+
+// FNV-1a sobre o tamanho, os valores e o grafo de desigualdades
+uint64_t _checkpoint_fingerprint(const Puzzle *p) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    size_t i, e, n = (size_t) p->size * p->size;
+
+    hash = (hash ^ p->size) * 0x100000001b3ull;
+    for (i = 0; i < n; i++) {
+        hash = (hash ^ p->cells[i / p->size][i % p->size]->val) * 0x100000001b3ull;
+        for (e = p->greaterStart[i]; e < p->greaterStart[i + 1]; e++)
+            hash = (hash ^ (CELL_INDEX(p, p->greater[e]) + 1)) * 0x100000001b3ull;
+        hash = (hash ^ 0xff) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// Bytes do arquivo após a posição atual, 0 se não for possível saber
+uint64_t _checkpoint_remaining(FILE *f) {
+    long pos = ftell(f), end;
+
+    if (pos < 0 || fseek(f, 0, SEEK_END) != 0)
+        return 0;
+    end = ftell(f);
+    if (fseek(f, pos, SEEK_SET) != 0 || end < pos)
+        return 0;
+    return end - pos;
+}
+
+Checkpoint *checkpoint_read(const char *path) {
+    FILE *f = fopen(path, "rb");
+    Checkpoint *cp;
+    bool ok;
+
+    if (f == NULL)
+        return NULL;
+
+    cp = malloc(sizeof(*cp));
+    cp->path = NULL;
+    cp->entries = NULL;
+
+    ok = fread(&cp->h, sizeof(cp->h), 1, f) == 1
+            && memcmp(cp->h.magic, CHECKPOINT_MAGIC, 4) == 0
+            && cp->h.version == CHECKPOINT_VERSION
+            && cp->h.depth <= UCHAR_MAX * UCHAR_MAX;
+    if (ok) {
+        cp->path = malloc(3 * (size_t) cp->h.depth + 1);
+        ok = fread(cp->path, 3, cp->h.depth, f) == cp->h.depth;
+    }
+    if (ok && cp->h.nEntries > 0) {
+        // O número de hashes vem do arquivo, que precisa de fato contê-los
+        ok = cp->h.nEntries <= SIZE_MAX / sizeof(*cp->entries)
+                && cp->h.nEntries <= _checkpoint_remaining(f) / sizeof(*cp->entries);
+    }
+    if (ok && cp->h.nEntries > 0) {
+        cp->entries = malloc(cp->h.nEntries * sizeof(*cp->entries));
+        ok = cp->entries != NULL
+                && fread(cp->entries, sizeof(*cp->entries), cp->h.nEntries, f) == cp->h.nEntries;
+    }
+    fclose(f);
+
+    if (!ok) {
+        checkpoint_destroy(cp);
+        return NULL;
+    }
+    return cp;
+}
+
+void checkpoint_destroy(Checkpoint *cp) {
+    free(cp->path);
+    free(cp->entries);
+    free(cp);
+}
+
+uint64_t checkpoint_tag(const Checkpoint *cp) {
+    return cp->h.tag;
+}
+
+bool checkpoint_matches(const Checkpoint *cp, const Puzzle *p, const SolverConfig *cfg, bool counting) {
+    uint32_t config[CONFIG_FIELDS];
+
+    _checkpoint_config(cfg, config);
+    return cp->h.fingerprint == _checkpoint_fingerprint(p)
+            && memcmp(cp->h.config, config, sizeof(config)) == 0
+            && cp->h.counting == counting
+            && cp->h.depth <= (size_t) p->size * p->size;
+}
+
+// Fim do caminho salvo: a busca segue daqui com as contagens salvas
+void _checkpoint_finish(Search *s) {
+    *s->assignments = s->resume->h.assignments;
+    s->solutions = s->resume->h.solutions;
+    s->resume = NULL;
+}
+
+void _checkpoint_begin(Search *s) {
+    const Checkpoint *cp = s->resume;
+    uint64_t i;
+
+    if (!checkpoint_matches(cp, s->p, s->cfg, s->counting)) {
+        s->resume = NULL;
+        s->status = SOLVE_CANCELLED;
+        return;
+    }
+
+    if (s->table != NULL)
+        for (i = 0; i < cp->h.nEntries; i++)
+            transtable_insert(s->table, cp->entries[i]);
+
+    if (cp->h.depth == 0)
+        _checkpoint_finish(s);
+}
+
+bool _checkpoint_replay(Search *s, Cell *c) {
+    const uchar *step = s->resume->path + 3 * (size_t) s->depth;
+    bool assigned;
+
+    // A escolha das células é determinística; outra célula aqui indica um
+    // estado que não corresponde a esta busca
+    if (c->row != step[0] || c->col != step[1]) {
+        s->resume = NULL;
+        s->status = SOLVE_CANCELLED;
+        return false;
+    }
+
+    assigned = _cell_valueFrom(s, c, step[2]);
+    if (s->depth + 1 == s->resume->h.depth)
+        _checkpoint_finish(s);
+    return assigned;
+}
+
+void _checkpoint_write(Search *s) {
+    const char *file = s->opts->checkpoint;
+    char *tmp = malloc(strlen(file) + 5);
+    uchar *path = malloc(3 * (size_t) s->depth + 1);
+    uint64_t *entries = NULL;
+    CheckpointHeader h;
+    unsigned int d;
+    FILE *f;
+    bool ok;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CHECKPOINT_MAGIC, 4);
+    h.version = CHECKPOINT_VERSION;
+    h.tag = s->opts->checkpointTag;
+    h.fingerprint = s->fingerprint;
+    h.solutions = s->solutions;
+    h.assignments = *s->assignments;
+    _checkpoint_config(s->cfg, h.config);
+    h.counting = s->counting;
+    h.depth = s->depth;
+
+    for (d = 0; d < s->depth; d++) {
+        path[3 * d] = s->path[d]->row;
+        path[3 * d + 1] = s->path[d]->col;
+        path[3 * d + 2] = s->path[d]->orderPos;
+    }
+    if (s->table != NULL) {
+        entries = malloc(transtable_capacity(s->table) * sizeof(*entries));
+        h.nEntries = transtable_entries(s->table, entries);
+    }
+
+    // Escrito ao lado e renomeado, para que uma interrupção no meio da
+    // escrita não destrua o estado anterior
+    sprintf(tmp, "%s.tmp", file);
+    f = fopen(tmp, "wb");
+    if (f != NULL) {
+        ok = fwrite(&h, sizeof(h), 1, f) == 1
+                && fwrite(path, 3, h.depth, f) == h.depth
+                && fwrite(entries, sizeof(*entries), h.nEntries, f) == h.nEntries;
+        ok = fclose(f) == 0 && ok;
+        if (!ok || rename(tmp, file) != 0)
+            remove(tmp);
+    }
+
+    free(entries);
+    free(path);
+    free(tmp);
+}
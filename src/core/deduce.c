@@ -0,0 +1,321 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "core/futoshiki.h"
+#include "core/puzzle.h"
+
+/*
+ * Estado da dedução, separado das células do tabuleiro: parte só dos
+ * valores dados, para que a nota não dependa do que a carga do tabuleiro já
+ * simplificou, e nunca precisa ser desfeito.
+ */
+typedef struct Deduction {
+    Puzzle *p;
+    uchar n;
+
+    // Valor de cada célula, linha a linha, 0 se ainda não deduzido
+    uchar *val;
+    size_t filled;
+
+    // cand[i * n + v - 1] indica se v ainda é possível na célula i, e
+    // count[i] quantos valores são
+    uchar *cand;
+    uchar *count;
+
+    bool unsat;
+
+    // Células alcançadas a partir da célula analisada pela regra das
+    // cadeias, e a marca das já visitadas
+    size_t *reach;
+    unsigned int *seen;
+    unsigned int stamp;
+
+    // Para cada linha e coluna, quantas das células alcançadas estão nela e
+    // a união de seus valores possíveis
+    unsigned int *lineCount;
+    uchar *lineUnion;
+} Deduction;
+
+// Retorna se v ainda era possível na célula i
+bool _deduce_remove(Deduction *d, size_t i, uchar v) {
+    uchar *c = &d->cand[i * d->n + v - 1];
+
+    if (!*c)
+        return false;
+    *c = 0;
+    if (--d->count[i] == 0)
+        d->unsat = true;
+    return true;
+}
+
+void _deduce_assign(Deduction *d, size_t i, uchar v) {
+    size_t row = i / d->n, col = i % d->n;
+    uchar k;
+
+    if (!d->cand[i * d->n + v - 1]) {
+        d->unsat = true;
+        return;
+    }
+    d->val[i] = v;
+    d->filled++;
+    memset(d->cand + i * d->n, 0, d->n);
+    d->cand[i * d->n + v - 1] = 1;
+    d->count[i] = 1;
+
+    for (k = 0; k < d->n; k++) {
+        if (k != col)
+            _deduce_remove(d, row * d->n + k, v);
+        if (k != row)
+            _deduce_remove(d, k * d->n + col, v);
+    }
+}
+
+uchar _deduce_min(Deduction *d, size_t i) {
+    uchar v;
+
+    for (v = 1; v < d->n && !d->cand[i * d->n + v - 1]; v++);
+    return v;
+}
+
+uchar _deduce_max(Deduction *d, size_t i) {
+    uchar v;
+
+    for (v = d->n; v > 1 && !d->cand[i * d->n + v - 1]; v--);
+    return v;
+}
+
+bool _deduce_singles(Deduction *d) {
+    size_t i, nCells = (size_t) d->n * d->n;
+    bool progress = false;
+
+    for (i = 0; i < nCells && !d->unsat; i++) {
+        if (d->val[i] == 0 && d->count[i] == 1) {
+            _deduce_assign(d, i, _deduce_min(d, i));
+            progress = true;
+        }
+    }
+    return progress;
+}
+
+bool _deduce_bounds(Deduction *d) {
+    Puzzle *p = d->p;
+    size_t i, g, e, nCells = (size_t) d->n * d->n;
+    unsigned int v, lim;
+    bool progress = false;
+
+    for (i = 0; i < nCells && !d->unsat; i++) {
+        for (e = p->greaterStart[i]; e < p->greaterStart[i + 1] && !d->unsat; e++) {
+            g = CELL_INDEX(p, p->greater[e]);
+
+            lim = _deduce_min(d, i);
+            for (v = 1; v <= lim; v++)
+                progress |= _deduce_remove(d, g, v);
+
+            lim = _deduce_max(d, g);
+            for (v = lim; v <= d->n; v++)
+                progress |= _deduce_remove(d, i, v);
+        }
+    }
+    return progress;
+}
+
+bool _deduce_hidden(Deduction *d) {
+    size_t n = d->n, line, k, at, cell, places;
+    unsigned int v;
+    bool progress = false;
+
+    // Linhas de 0 a n - 1, colunas de n a 2n - 1
+    for (line = 0; line < 2 * n && !d->unsat; line++) {
+        for (v = 1; v <= n && !d->unsat; v++) {
+            places = 0;
+            at = 0;
+            for (k = 0; k < n; k++) {
+                cell = line < n ? line * n + k : k * n + line - n;
+                if (d->cand[cell * n + v - 1]) {
+                    places++;
+                    at = cell;
+                }
+            }
+
+            if (places == 0) {
+                d->unsat = true;
+            } else if (places == 1 && d->val[at] == 0) {
+                _deduce_assign(d, at, v);
+                progress = true;
+            }
+        }
+    }
+    return progress;
+}
+
+// Reúne em d->reach as células transitivamente maiores (ou menores) que a
+// de índice i, retornando quantas são
+size_t _deduce_reach(Deduction *d, size_t i, bool greater) {
+    Puzzle *p = d->p;
+    size_t *start = greater ? p->greaterStart : p->smallerStart;
+    Cell **adj = greater ? p->greater : p->smaller;
+    size_t head = 0, tail = 0, e, j;
+
+    d->stamp++;
+    d->seen[i] = d->stamp;
+    j = i;
+    for (;;) {
+        for (e = start[j]; e < start[j + 1]; e++) {
+            if (d->seen[CELL_INDEX(p, adj[e])] != d->stamp) {
+                d->seen[CELL_INDEX(p, adj[e])] = d->stamp;
+                d->reach[tail++] = CELL_INDEX(p, adj[e]);
+            }
+        }
+        if (head == tail)
+            return tail;
+        j = d->reach[head++];
+    }
+}
+
+// Limita a célula i pelas células alcançadas de cada linha e coluna: são k
+// valores distintos, todos maiores (ou menores) que o de i, então i fica
+// abaixo do k-ésimo maior (ou acima do k-ésimo menor) valor de sua união
+bool _deduce_bound(Deduction *d, size_t i, size_t nReach, bool greater) {
+    size_t n = d->n, r, line, l;
+    unsigned int k, v, w, bound;
+    bool progress = false;
+
+    memset(d->lineCount, 0, 2 * n * sizeof(*d->lineCount));
+    memset(d->lineUnion, 0, 2 * n * n);
+    for (r = 0; r < nReach; r++) {
+        for (l = 0; l < 2; l++) {
+            line = l == 0 ? d->reach[r] / n : n + d->reach[r] % n;
+            d->lineCount[line]++;
+            for (v = 0; v < n; v++)
+                d->lineUnion[line * n + v] |= d->cand[d->reach[r] * n + v];
+        }
+    }
+
+    for (line = 0; line < 2 * n && !d->unsat; line++) {
+        if (d->lineCount[line] < 2)
+            continue;
+
+        bound = 0;
+        k = 0;
+        for (w = 1; w <= n && bound == 0; w++) {
+            v = greater ? n + 1 - w : w;
+            if (d->lineUnion[line * n + v - 1] && ++k == d->lineCount[line])
+                bound = v;
+        }
+        if (bound == 0) {
+            d->unsat = true;
+            break;
+        }
+
+        for (v = greater ? bound : 1; v <= (greater ? n : bound); v++)
+            progress |= _deduce_remove(d, i, v);
+    }
+    return progress;
+}
+
+bool _deduce_chains(Deduction *d) {
+    size_t i, nReach, nCells = (size_t) d->n * d->n;
+    bool progress = false;
+
+    // Com uma só célula alcançada por linha a regra nada acrescenta à dos
+    // limites, e _deduce_bound as ignora
+    for (i = 0; i < nCells && !d->unsat; i++) {
+        if (d->val[i] != 0)
+            continue;
+        nReach = _deduce_reach(d, i, true);
+        progress |= _deduce_bound(d, i, nReach, true);
+        nReach = _deduce_reach(d, i, false);
+        if (!d->unsat)
+            progress |= _deduce_bound(d, i, nReach, false);
+    }
+    return progress;
+}
+
+// Regras em ordem de dificuldade; a i-ésima corresponde à nota i + 1
+static bool (*const rules[])(Deduction *) = {
+    _deduce_singles,
+    _deduce_bounds,
+    _deduce_hidden,
+    _deduce_chains
+};
+
+#define N_RULES (sizeof(rules) / sizeof(*rules))
+
+// Retorna se os valores deduzidos respeitam todas as desigualdades
+bool _deduce_consistent(Deduction *d) {
+    Puzzle *p = d->p;
+    size_t i, e, nCells = (size_t) d->n * d->n;
+
+    for (i = 0; i < nCells; i++)
+        for (e = p->greaterStart[i]; e < p->greaterStart[i + 1]; e++)
+            if (d->val[i] >= d->val[CELL_INDEX(p, p->greater[e])])
+                return false;
+    return true;
+}
+
+DeductionGrade puzzle_deduce(Puzzle *p) {
+    Deduction d;
+    size_t i, nCells = (size_t) p->size * p->size;
+    DeductionGrade grade = GRADE_SINGLES;
+    unsigned int r;
+    Cell *c;
+
+    if (p->unsat)
+        return GRADE_UNSAT;
+
+    d.p = p;
+    d.n = p->size;
+    d.val = calloc(nCells, sizeof(*d.val));
+    d.filled = 0;
+    d.cand = malloc(nCells * d.n);
+    memset(d.cand, 1, nCells * d.n);
+    d.count = malloc(nCells * sizeof(*d.count));
+    memset(d.count, d.n, nCells * sizeof(*d.count));
+    d.unsat = false;
+    d.reach = malloc(nCells * sizeof(*d.reach));
+    d.seen = calloc(nCells, sizeof(*d.seen));
+    d.stamp = 0;
+    d.lineCount = malloc(2 * d.n * sizeof(*d.lineCount));
+    d.lineUnion = malloc(2 * (size_t) d.n * d.n);
+
+    for (i = 0; i < nCells && !d.unsat; i++)
+        if (p->givens[i] != 0)
+            _deduce_assign(&d, i, p->givens[i]);
+
+    while (!d.unsat && d.filled < nCells) {
+        for (r = 0; r < N_RULES && !d.unsat && !rules[r](&d); r++);
+        if (r == N_RULES)
+            break;
+        if (r + 1 > (unsigned int) grade)
+            grade = r + 1;
+    }
+
+    if (!d.unsat && d.filled == nCells && !_deduce_consistent(&d))
+        d.unsat = true;
+    if (d.unsat) {
+        grade = GRADE_UNSAT;
+    } else {
+        if (d.filled < nCells)
+            grade = GRADE_STALLED;
+
+        // Valores deduzidos valem em toda solução e podem ser atribuídos
+        // como os da simplificação
+        for (i = 0; i < nCells; i++) {
+            c = p->cells[i / p->size][i % p->size];
+            if (c->val == 0 && d.val[i] != 0) {
+                _updateRestrictedValues(p, c, d.val[i]);
+                c->val = d.val[i];
+            }
+        }
+    }
+
+    free(d.val);
+    free(d.cand);
+    free(d.count);
+    free(d.reach);
+    free(d.seen);
+    free(d.lineCount);
+    free(d.lineUnion);
+    return grade;
+}
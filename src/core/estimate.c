@@ -0,0 +1,98 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "core/futoshiki.h"
+#include "core/puzzle.h"
+
+uint64_t _estimate_random(uint64_t *rng) {
+    *rng ^= *rng << 13;
+    *rng ^= *rng >> 7;
+    *rng ^= *rng << 17;
+    return *rng;
+}
+
+// Desce por um caminho aleatório da árvore de busca, escolhendo a célula e
+// propagando como _backtrack, e retorna a estimativa de Knuth do número de
+// nós: 1 + d1 + d1 d2 + ..., onde di é o número de filhos do i-ésimo nó do
+// caminho. O tabuleiro volta ao estado inicial antes de retornar.
+double _estimate_probe(Search *s, uint64_t *rng, uchar *children, bool *solved) {
+    Puzzle *p = s->p;
+    Cell *c = cell_nextInSeq(s, NULL);
+    double estimate = 1, weight = 1;
+    unsigned int n;
+
+    s->depth = 0;
+    while (c != NULL) {
+        if (s->depth < s->cfg->probeDepth && !_probe(s))
+            break;
+
+        // Filhos do nó: valores que passam pela propagação e pela quebra de
+        // simetria, na ordem da busca
+        n = 0;
+        while (cell_nextValue(s, c))
+            if (!s->cfg->symmetryBreaking || symmetry_allowed(p, &p->sym))
+                children[n++] = c->orderPos;
+        if (n == 0)
+            break;
+
+        weight *= n;
+        estimate += weight;
+        _cell_valueFrom(s, c, children[_estimate_random(rng) % n]);
+        s->path[s->depth++] = c;
+        c = cell_nextInSeq(s, c);
+    }
+    *solved = c == NULL && puzzle_checkSolved(p);
+
+    while (s->depth > 0) {
+        c = s->path[--s->depth];
+        s->kernel->update(p, c, 0);
+        c->val = 0;
+    }
+    _probe_undo(s, 0);
+
+    return estimate;
+}
+
+SearchEstimate puzzle_estimate(Puzzle *p, const SolveOptions *opts, unsigned int probes) {
+    SolveOptions local = opts != NULL ? *opts : solveoptions_default();
+    SearchEstimate est = {0, 0, 0, 0};
+    Search s;
+    uchar *children;
+    uint64_t rng;
+    double x, sum = 0, sumSq = 0, var;
+    int64_t assignments = 0;
+    bool solved;
+
+    if (p->unsat)
+        return est;
+
+    // A estimativa não deixa rastros: sem estatísticas, tabela ou estado salvo
+    local.stats = NULL;
+    local.trace = NULL;
+    local.transpositions = NULL;
+    local.checkpoint = NULL;
+    local.resume = NULL;
+    _search_init(&s, p, &local, NULL, &assignments);
+    children = malloc(p->size * sizeof(*children));
+    rng = (uint64_t) local.config.seed * 0x9E3779B97F4A7C15ull + 1;
+
+    while (est.probes < probes && (est.probes == 0 || assignments < ESTIMATE_BUDGET)) {
+        x = _estimate_probe(&s, &rng, children, &solved);
+        sum += x;
+        sumSq += x * x;
+        est.probes++;
+        est.solutions += solved;
+    }
+
+    est.nodes = sum / est.probes;
+    if (est.probes > 1) {
+        var = (sumSq - sum * est.nodes) / (est.probes - 1);
+        est.error = var > 0 ? sqrt(var / est.probes) / est.nodes : 0;
+    }
+
+    free(children);
+    _search_free(&s);
+    return est;
+}
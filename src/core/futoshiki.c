@@ -2,49 +2,15 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
 
 #include "core/futoshiki.h"
-#include "struct/list.h"
-#include "struct/bitarray.h"
-
-typedef unsigned char uchar;
-
-typedef struct Cell {
-    // Valor atual da célula
-    uchar val;
-
-    // Posição da célula na grade
-    uchar row;
-    uchar col;
-
-    // Vetor e número de limitações
-    // Cada limitação é uma célula estritamente maior que esta
-    uchar nConstr;
-    struct Cell *constr[4];
-
-    // Vetor onde cada posição i representa o número de células que impedem
-    // o valor i+1 de ser posto nesta célula.
-    // Mais adequado que um vetor de valores booleanos pois permite subtrair
-    // 1 do valor na volta do backtracking e somar 1 ao prosseguir à próxima
-    // célula.
-    uchar *restrictedValues;
-
-    // Número de valores que podem ser colocados nesta célula.
-    // Equivalente ao número de valores 0 em restrictedValues.
-    uchar nPossibilities;
-
-} Cell;
-
-struct Puzzle {
-    Cell ***cells;
-
-    // Número de células por lado do jogo
-    uchar size;
-
-    // Lista de todas as células que possuem alguma limitação
-    List *constrCells;
-};
-
+#include "core/puzzle.h"
+#include "struct/bitset.h"
+#include "core/transtable.h"
+#include "core/checkpoint.h"
 
 Cell *cell_new(Puzzle *p, uchar row, uchar col, uchar val) {
     Cell *c = malloc(sizeof(*c));
@@ -52,9 +18,13 @@ Cell *cell_new(Puzzle *p, uchar row, uchar col, uchar val) {
     c->val = val;
     c->row = row;
     c->col = col;
-    c->nConstr = 0;
+    c->greater = NULL;
+    c->nGreater = 0;
+    c->smaller = NULL;
+    c->nSmaller = 0;
     c->restrictedValues = calloc(p->size, sizeof(*c->restrictedValues));
     c->nPossibilities = p->size;
+    c->orderPos = 0;
 
     return c;
 }
@@ -124,9 +94,32 @@ void _updateRestrictedValues(Puzzle *p, Cell *c, uchar newVal) {
     _strengthenRestrValues(p, c->row, c->col, newVal);
 }
 
-// Retorna se o tabuleiro ainda pode teoricamente ser resolvido.
-// Procura por alguma célula sem valores possíveis.
-bool _forwardCheck(Puzzle *p) {
+// Retorna se alguma limitação já não pode mais ser satisfeita, ou seja, se
+// existe um par c < other em que o menor valor possível de c não é menor que
+// o maior valor possível de other.
+bool _ineqViolated(Puzzle *p) {
+    Cell *c;
+    uchar i, j, lo, hi;
+    unsigned int k;
+
+    for (i = 0; i < p->size; i++) {
+        for (j = 0; j < p->size; j++) {
+            c = p->cells[i][j];
+            if (c->nGreater == 0)
+                continue;
+            lo = cell_smallestPossibility(p, c);
+            for (k = 0; k < c->nGreater; k++) {
+                hi = cell_greatestPossibility(p, c->greater[k]);
+                if (lo > 0 && hi > 0 && lo >= hi)
+                    return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Retorna se nenhuma célula vazia ficou sem valores possíveis
+bool _cellsFeasible(Puzzle *p) {
     uchar i, j;
 
     for (i = 0; i < p->size; i++)
@@ -136,89 +129,184 @@ bool _forwardCheck(Puzzle *p) {
     return true;
 }
 
-// Cicla pelos valores possíveis da célula.
-// Retorna true se houver um próximo valor, retorna false caso contrário.
-// Automaticamente ajusta o valor de volta para 0 se não houver mais valores.
-bool cell_nextValue(Puzzle *p, Cell *c, int *assignments) {
+// Retorna se o tabuleiro ainda pode teoricamente ser resolvido.
+// Procura por alguma célula sem valores possíveis.
+bool _forwardCheck(Search *s) {
+    Puzzle *p = s->p;
+    bool feasible, violated;
+
+    STATS_INC(s, forwardChecks);
+    TIMER_START(t);
+    feasible = s->kernel->feasible(p);
+    TIMER_STOP(s, PHASE_FORWARD_CHECK, t);
+    if (!feasible) {
+        STATS_INC(s, rowColWipeouts);
+        return false;
+    }
+
+    if (s->cfg->ineqCheck) {
+        STATS_INC(s, ineqChecks);
+        TIMER_START(ti);
+        violated = _ineqViolated(p);
+        TIMER_STOP(s, PHASE_INEQ_CHECK, ti);
+        if (violated) {
+            STATS_INC(s, ineqWipeouts);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Forward checking após a atribuição de um valor à célula c
+bool _propagate(Search *s, Cell *c) {
+    if (_forwardCheck(s)) {
+        TRACE(s, TRACE_PROPAGATE, c, c->val);
+        return true;
+    }
+    TRACE(s, TRACE_WIPEOUT, c, c->val);
+    return false;
+}
+
+// Chave de Zobrist do valor v na célula c, 0 para célula vazia. Gerada pelo
+// splitmix64 a partir da posição e do valor, sem tabela, para que todas as
+// buscas do mesmo tabuleiro concordem sobre as chaves.
+uint64_t _zobrist(const Puzzle *p, const Cell *c, uchar v) {
+    uint64_t x;
+
+    if (v == 0)
+        return 0;
+    x = (CELL_INDEX(p, c) * (UCHAR_MAX + 1) + v) * 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+// Hash de Zobrist da grade inteira
+uint64_t _gridHash(const Puzzle *p) {
+    uint64_t hash = 0;
+    uchar i, j;
+
+    for (i = 0; i < p->size; i++)
+        for (j = 0; j < p->size; j++)
+            hash ^= _zobrist(p, p->cells[i][j], p->cells[i][j]->val);
+    return hash;
+}
+
+// Atribui à célula o primeiro valor possível a partir da posição pos da
+// ordem de valores, ou 0 se não houver nenhum. Retorna se algum valor foi
+// atribuído.
+bool _cell_valueFrom(Search *s, Cell *c, uchar pos) {
+    Puzzle *p = s->p;
     uchar newVal;
-#if OPT_LEVEL >= OPT_FORWARD_CHECKING
+
     // Em caso de forward checking, repetir até que _forwardCheck retorne true
     do {
-#endif
-        newVal = c->val+1;
-
-        while (newVal <= p->size && c->restrictedValues[newVal-1] > 0) {
-            newVal++;
-        }
+        while (pos < p->size && c->restrictedValues[s->valueOrder[pos]-1] > 0)
+            pos++;
 
-        if (newVal > p->size)
+        if (pos < p->size)
+            newVal = s->valueOrder[pos];
+        else
             newVal = 0;
 
-        _updateRestrictedValues(p, c, newVal);
+        if (s->table != NULL)
+            s->hash ^= _zobrist(p, c, c->val) ^ _zobrist(p, c, newVal);
+        s->kernel->update(p, c, newVal);
         c->val = newVal;
-#if OPT_LEVEL >= OPT_FORWARD_CHECKING
+        c->orderPos = pos;
+        pos++;
+        if (newVal > 0)
+            TRACE(s, TRACE_DECIDE, c, newVal);
     // Se newVal == 0 não há mais valores a serem checados
-    } while (newVal > 0 && !_forwardCheck(p));
-#endif
+    } while (s->cfg->forwardChecking && newVal > 0 && !_propagate(s, c));
+
+    if (newVal == 0)
+        TRACE(s, TRACE_BACKTRACK, c, 0);
 
-    (*assignments)++;
+    (*s->assignments)++;
     return c->val > 0;
 }
 
+// Esvazia a célula, desfazendo as restrições de seu valor
+void _cell_clear(Search *s, Cell *c) {
+    if (s->table != NULL)
+        s->hash ^= _zobrist(s->p, c, c->val);
+    s->kernel->update(s->p, c, 0);
+    c->val = 0;
+}
 
+// Cicla pelos valores possíveis da célula, na ordem dada por s->valueOrder.
+// Retorna true se houver um próximo valor, retorna false caso contrário.
+// Automaticamente ajusta o valor de volta para 0 se não houver mais valores.
+bool cell_nextValue(Search *s, Cell *c) {
+    return _cell_valueFrom(s, c, c->val == 0 ? 0 : c->orderPos + 1);
+}
 
-// Retorna a próxima célula a ser processada pelo algoritmo
-Cell *cell_nextInSeq(Puzzle *p, Cell *c) {
-    uchar i, j;
 
-#if OPT_LEVEL < OPT_MVR
-    // Se a heurística MVR não for utilizada, procurar a próxima célula vazia
-    // à direita e abaixo desta.
 
-    // Iniciar a busca na mesma linha e coluna à direita desta
-    i = c->row;
-    j = c->col + 1;
+// Retorna a próxima célula a ser processada pelo algoritmo, a partir de c.
+// Se c for NULL, a busca começa do início do tabuleiro.
+Cell *_nextInSeq(Search *s, Cell *c) {
+    Puzzle *p = s->p;
+    uchar i, j;
 
-    while (i < p->size) {
-        while (j < p->size) {
-            if (p->cells[i][j]->val == 0)
-                return p->cells[i][j];
-            j++;
+    if (!s->cfg->mvr) {
+        // Se a heurística MVR não for utilizada, procurar a próxima célula vazia
+        // à direita e abaixo desta.
+
+        // Iniciar a busca na mesma linha e coluna à direita desta
+        if (c == NULL) {
+            i = 0;
+            j = 0;
+        } else {
+            i = c->row;
+            j = c->col + 1;
         }
 
-        j = 0;
-        i++;
-    }
-    return NULL;
+        while (i < p->size) {
+            while (j < p->size) {
+                if (p->cells[i][j]->val == 0)
+                    return p->cells[i][j];
+                j++;
+            }
 
-#else
+            j = 0;
+            i++;
+        }
+        return NULL;
+    }
 
     // Se a heurística MVR for utilizada, procurar pela célula com menor valor
     // nPossibilities dentre todas as células em branco.
-    Cell *easiest = NULL;
+    return s->kernel->mostConstrained(p);
+}
+
+// Célula em branco com menos valores possíveis; em caso de empate, a
+// primeira na ordem das linhas
+Cell *_mostConstrained(Puzzle *p) {
+    Cell *easiest = NULL, *c;
     uchar easiestComplexity = UCHAR_MAX;
-    uchar currComplexity;
-    i = 0;
-    j = 0;
+    uchar i, j;
 
-    while (i < p->size) {
-        j = 0;
-        while (j < p->size) {
+    for (i = 0; i < p->size; i++) {
+        for (j = 0; j < p->size; j++) {
             c = p->cells[i][j];
-            if (c->val == 0) {
-                currComplexity = c->nPossibilities;
-                if (currComplexity < easiestComplexity) {
-                    easiest = c;
-                    easiestComplexity = currComplexity;
-                }
+            if (c->val == 0 && c->nPossibilities < easiestComplexity) {
+                easiest = c;
+                easiestComplexity = c->nPossibilities;
             }
-            j++;
         }
-        i++;
     }
-
     return easiest;
-#endif
+}
+
+Cell *cell_nextInSeq(Search *s, Cell *c) {
+    Cell *next;
+
+    TIMER_START(t);
+    next = _nextInSeq(s, c);
+    TIMER_STOP(s, PHASE_SELECT, t);
+    return next;
 }
 
 // Retorna o menor valor que a célula pode assumir
@@ -246,17 +334,18 @@ uchar cell_greatestPossibility(Puzzle *p, Cell *c) {
 // Atualiza o vetor de possibilidades.
 // Retorna se algum vetor foi alterado.
 bool _updateIneqRestr(Puzzle *p) {
-    ListIterator *iter = list_iterator(p->constrCells);
     Cell *c, *other;
-    uchar i, j, lim;
+    uchar j, lim;
+    size_t n;
+    unsigned int k;
     bool altered = false;
 
     // Para cada célula com limitações
-    while (listiter_hasNext(iter)) {
-        c = listiter_next(iter);
+    for (n = 0; n < (size_t) p->size * p->size; n++) {
+        c = p->cells[n / p->size][n % p->size];
         // Para cada limitação
-        for (i = 0; i < c->nConstr; i++) {
-            other = c->constr[i];
+        for (k = 0; k < c->nGreater; k++) {
+            other = c->greater[k];
 
             // Sabe-se que other->val > min(c)
             // Logo, todo valor menor que ou igual o valor mínimo de c é
@@ -284,7 +373,6 @@ bool _updateIneqRestr(Puzzle *p) {
         }
     }
 
-    listiter_destroy(iter);
     return altered;
 }
 
@@ -319,47 +407,88 @@ void puzzle_simplify(Puzzle *p) {
 }
 
 
-// Adicionar uma nova limitação tal que c1 < c2
-void puzzle_addConstr(Puzzle *p, Cell *c1, Cell *c2) {
-    if (c1->nConstr == 0) // Not yet in the list
-        list_append(p->constrCells, c1);
+// Monta o grafo de desigualdades em CSR: para cada limitação c1 < c2, c2
+// entra no trecho de maiores de c1 e c1 no trecho de menores de c2
+void puzzle_buildGraph(Puzzle *p, size_t nConstr, const PuzzleConstr *constr) {
+    size_t nCells = (size_t) p->size * p->size;
+    size_t n;
+    Cell *c, *lo, *hi;
+
+    free(p->greaterStart);
+    free(p->greater);
+    free(p->smallerStart);
+    free(p->smaller);
+
+    p->nConstr = nConstr;
+    p->greaterStart = calloc(nCells + 1, sizeof(*p->greaterStart));
+    p->smallerStart = calloc(nCells + 1, sizeof(*p->smallerStart));
+    p->greater = malloc((nConstr + 1) * sizeof(*p->greater));
+    p->smaller = malloc((nConstr + 1) * sizeof(*p->smaller));
+
+    // Contagem de vizinhas de cada célula, deslocada de uma posição para
+    // virar o início de cada trecho após a soma de prefixos
+    for (n = 0; n < nConstr; n++) {
+        p->greaterStart[constr[n].r1 * p->size + constr[n].c1 + 1]++;
+        p->smallerStart[constr[n].r2 * p->size + constr[n].c2 + 1]++;
+    }
+    for (n = 0; n < nCells; n++) {
+        p->greaterStart[n + 1] += p->greaterStart[n];
+        p->smallerStart[n + 1] += p->smallerStart[n];
+    }
 
-    c1->constr[c1->nConstr] = c2;
-    c1->nConstr++;
+    // Cada célula aponta para o seu trecho, preenchido na ordem de entrada
+    for (n = 0; n < nCells; n++) {
+        c = p->cells[n / p->size][n % p->size];
+        c->greater = p->greater + p->greaterStart[n];
+        c->nGreater = 0;
+        c->smaller = p->smaller + p->smallerStart[n];
+        c->nSmaller = 0;
+    }
+    for (n = 0; n < nConstr; n++) {
+        lo = p->cells[constr[n].r1][constr[n].c1];
+        hi = p->cells[constr[n].r2][constr[n].c2];
+        lo->greater[lo->nGreater++] = hi;
+        hi->smaller[hi->nSmaller++] = lo;
+    }
 }
 
-// Cria um novo tabuleiro com os dados formatados segundo o especificado.
-// Os dados são lidos da stream de dados passada.
-Puzzle *puzzle_new(FILE *stream) {
-    uchar nConstr;
-    uchar v;
-    uchar i, j;
-    uchar k, l;
-
-    Puzzle *p = malloc(sizeof(*p));
+// Retorna se a grade e as limitações estão dentro dos limites do tamanho.
+bool _validGrid(uchar size, const uchar *grid, size_t nConstr, const PuzzleConstr *constr) {
+    size_t n;
 
-    // Leitura do tamanho e número de limitações
-    fscanf(stream, "%hhu%hhu", &p->size, &nConstr);
+    if (size == 0)
+        return false;
+    for (n = 0; n < (size_t) size * size; n++)
+        if (grid[n] > size)
+            return false;
+    for (n = 0; n < nConstr; n++)
+        if (constr[n].r1 >= size || constr[n].c1 >= size
+                || constr[n].r2 >= size || constr[n].c2 >= size)
+            return false;
+    return true;
+}
 
-    // Alocação da matriz de células
-    p->cells = malloc(p->size * sizeof(*p->cells));
+// (Re)inicializa as células já alocadas do tabuleiro com a grade e as
+// limitações dadas.
+void _puzzle_load(Puzzle *p, const uchar *grid, size_t nConstr, const PuzzleConstr *constr) {
+    uchar v;
+    uchar i, j, k;
+    Cell *c;
 
     for (i = 0; i < p->size; i++) {
-        p->cells[i] = malloc(p->size * sizeof(**p->cells));
         for (j = 0; j < p->size; j++) {
-            fscanf(stream, "%hhu", &v);
-            p->cells[i][j] = cell_new(p, i, j, v);
+            c = p->cells[i][j];
+            c->val = grid[i * p->size + j];
+            for (k = 0; k < p->size; k++)
+                c->restrictedValues[k] = 0;
+            c->nPossibilities = p->size;
+            c->orderPos = 0;
         }
     }
+    memcpy(p->givens, grid, (size_t) p->size * p->size);
 
-    // Leitura e criação das limitações
-    p->constrCells = list_new();
-    while (nConstr > 0) {
-        fscanf(stream, "%hhu%hhu%hhu%hhu", &i, &j, &k, &l);
-        puzzle_addConstr(p, p->cells[i-1][j-1], p->cells[k-1][l-1]);
-        nConstr--;
-    }
-
+    // Criação das limitações
+    puzzle_buildGraph(p, nConstr, constr);
 
     // Atualização dos valores iniciais do vetor de restrições
     for (i = 0; i < p->size; i++) {
@@ -370,17 +499,293 @@ Puzzle *puzzle_new(FILE *stream) {
         }
     }
 
+    // Cadeias de desigualdades impossíveis dispensam qualquer busca
+    p->unsat = !puzzle_analyzeChains(p);
+
 #if OPT_LEVEL >= OPT_SIMPLIFY
     // Se nível de otimização permitir, simplificar o tabuleiro anteriormente.
-    puzzle_simplify(p);
+    if (!p->unsat)
+        puzzle_simplify(p);
 #endif
 
+    symmetry_detect(p, &p->sym);
+}
+
+// Cria um novo tabuleiro a partir da grade (valores linha a linha, 0 para
+// células vazias) e das limitações, com coordenadas começando em 0.
+// Retorna NULL se os dados forem inválidos.
+Puzzle *puzzle_fromGrid(uchar size, const uchar *grid, size_t nConstr, const PuzzleConstr *constr) {
+    uchar i, j;
+
+    if (!_validGrid(size, grid, nConstr, constr))
+        return NULL;
+
+    Puzzle *p = malloc(sizeof(*p));
+    p->size = size;
+    p->givens = malloc((size_t) size * size);
+
+    // Alocação da matriz de células
+    p->cells = malloc(p->size * sizeof(*p->cells));
+
+    for (i = 0; i < p->size; i++) {
+        p->cells[i] = malloc(p->size * sizeof(**p->cells));
+        for (j = 0; j < p->size; j++)
+            p->cells[i][j] = cell_new(p, i, j, 0);
+    }
+    p->greaterStart = NULL;
+    p->greater = NULL;
+    p->smallerStart = NULL;
+    p->smaller = NULL;
+
+    _puzzle_load(p, grid, nConstr, constr);
+    return p;
+}
+
+// Reaproveita a memória de reuse, se tiver o mesmo tamanho; caso contrário,
+// reuse é destruído e um novo tabuleiro é criado.
+Puzzle *_puzzle_reuse(Puzzle *reuse, uchar size, const uchar *grid, size_t nConstr, const PuzzleConstr *constr) {
+    if (reuse != NULL && reuse->size == size && _validGrid(size, grid, nConstr, constr)) {
+        _puzzle_load(reuse, grid, nConstr, constr);
+        return reuse;
+    }
+
+    if (reuse != NULL)
+        puzzle_destroy(reuse);
+    return puzzle_fromGrid(size, grid, nConstr, constr);
+}
+
+// Fonte de números inteiros do formato de entrada
+typedef bool (*ReadFunction) (void *, unsigned int *);
+
+bool _readStream(void *stream, unsigned int *out) {
+    return fscanf(stream, "%u", out) == 1;
+}
+
+typedef struct Buffer {
+    const char *pos;
+    const char *end;
+} Buffer;
+
+bool _readBuffer(void *src, unsigned int *out) {
+    Buffer *b = src;
+    unsigned int v = 0;
+
+    while (b->pos < b->end && (*b->pos == ' ' || *b->pos == '\n'
+                || *b->pos == '\t' || *b->pos == '\r'))
+        b->pos++;
+    if (b->pos == b->end || *b->pos < '0' || *b->pos > '9')
+        return false;
+
+    // Números que não cabem em um unsigned int são inválidos, e não
+    // truncados
+    while (b->pos < b->end && *b->pos >= '0' && *b->pos <= '9') {
+        if (v > (UINT_MAX - (*b->pos - '0')) / 10)
+            return false;
+        v = v * 10 + (*b->pos - '0');
+        b->pos++;
+    }
+
+    *out = v;
+    return true;
+}
+
+// Lê um tabuleiro no formato da entrada: tamanho, número de limitações,
+// a grade e as limitações, com coordenadas começando em 1.
+Puzzle *_puzzle_read(ReadFunction next, void *src, Puzzle *reuse) {
+    unsigned int size, nConstr, v[4];
+    uchar *grid;
+    PuzzleConstr *constr;
+    Puzzle *p = NULL;
+    size_t n;
+    bool ok;
+    int k;
+
+    // Cada célula tem no máximo 4 vizinhas, o mesmo limite de
+    // puzzle_textLength
+    if (!next(src, &size) || !next(src, &nConstr) || size == 0 || size > UCHAR_MAX
+            || nConstr > 4 * size * size) {
+        if (reuse != NULL)
+            puzzle_destroy(reuse);
+        return NULL;
+    }
+
+    grid = malloc(size * size * sizeof(*grid));
+    constr = malloc(nConstr * sizeof(*constr));
+    ok = grid != NULL && (constr != NULL || nConstr == 0);
+
+    for (n = 0; ok && n < size * size; n++) {
+        ok = next(src, &v[0]) && v[0] <= size;
+        grid[n] = v[0];
+    }
+
+    for (n = 0; ok && n < nConstr; n++) {
+        for (k = 0; ok && k < 4; k++)
+            ok = next(src, &v[k]) && v[k] >= 1 && v[k] <= size;
+        if (!ok)
+            break;
+        constr[n].r1 = v[0] - 1;
+        constr[n].c1 = v[1] - 1;
+        constr[n].r2 = v[2] - 1;
+        constr[n].c2 = v[3] - 1;
+    }
+
+    if (ok)
+        p = _puzzle_reuse(reuse, size, grid, nConstr, constr);
+    else if (reuse != NULL)
+        puzzle_destroy(reuse);
+
+    free(grid);
+    free(constr);
     return p;
 }
 
+// Cria um novo tabuleiro com os dados formatados segundo o especificado.
+// Os dados são lidos da stream de dados passada.
+Puzzle *puzzle_new(FILE *stream) {
+    return _puzzle_read(_readStream, stream, NULL);
+}
+
+Puzzle *puzzle_parseInto(Puzzle *reuse, const char *buf, size_t len, size_t *consumed) {
+    Buffer b;
+    Puzzle *p;
+
+    b.pos = buf;
+    b.end = buf + len;
+    p = _puzzle_read(_readBuffer, &b, reuse);
+    if (consumed != NULL)
+        *consumed = b.pos - buf;
+
+    return p;
+}
+
+Puzzle *puzzle_parse(const char *buf, size_t len, size_t *consumed) {
+    return puzzle_parseInto(NULL, buf, len, consumed);
+}
+
+// Retorna o tamanho do primeiro tabuleiro completo do buffer, 0 se ainda
+// faltarem dados ou -1 se o texto não for uma sequência de números.
+// Ao fim dos dados (eof), o último número não precisa de separador.
+long puzzle_textLength(const char *buf, size_t len, bool eof) {
+    size_t pos = 0, start;
+    unsigned long tokens = 0, needed = 2;
+    unsigned long v[2] = {0, 0};
+
+    while (tokens < needed) {
+        while (pos < len && (buf[pos] == ' ' || buf[pos] == '\n'
+                    || buf[pos] == '\t' || buf[pos] == '\r'))
+            pos++;
+        if (pos == len)
+            return 0;
+        if (buf[pos] < '0' || buf[pos] > '9')
+            return -1;
+
+        start = pos;
+        while (pos < len && buf[pos] >= '0' && buf[pos] <= '9')
+            pos++;
+        if (pos == len && !eof)
+            return 0;
+
+        // Tamanho e número de limitações definem quantos números faltam
+        if (tokens < 2) {
+            if (pos - start > 9)
+                return -1;
+            v[tokens] = strtoul(buf + start, NULL, 10);
+            // Tamanhos impossíveis não devem prender a conexão esperando
+            if (v[0] > UCHAR_MAX || v[1] > 4 * v[0] * v[0])
+                return -1;
+            if (tokens == 1)
+                needed = 2 + v[0] * v[0] + 4 * v[1];
+        }
+        tokens++;
+    }
+
+    return pos;
+}
+
+uchar puzzle_getSize(const Puzzle *p) {
+    return p->size;
+}
+
+void puzzle_getValues(const Puzzle *p, uchar *out) {
+    uchar i, j;
+
+    for (i = 0; i < p->size; i++)
+        for (j = 0; j < p->size; j++)
+            out[i * p->size + j] = p->cells[i][j]->val;
+}
+
+// Cria uma cópia independente do tabuleiro, incluindo o estado atual das
+// células e de seus vetores de restrição.
+Puzzle *puzzle_clone(const Puzzle *orig) {
+    size_t nCells = (size_t) orig->size * orig->size;
+    size_t n;
+    Cell *c, *oc;
+    uchar i, j, k;
+
+    Puzzle *p = malloc(sizeof(*p));
+    p->size = orig->size;
+    p->sym = orig->sym;
+    p->unsat = orig->unsat;
+    p->givens = malloc(nCells);
+    memcpy(p->givens, orig->givens, nCells);
+
+    p->cells = malloc(p->size * sizeof(*p->cells));
+    for (i = 0; i < p->size; i++) {
+        p->cells[i] = malloc(p->size * sizeof(**p->cells));
+        for (j = 0; j < p->size; j++) {
+            oc = orig->cells[i][j];
+            c = cell_new(p, i, j, oc->val);
+            for (k = 0; k < p->size; k++)
+                c->restrictedValues[k] = oc->restrictedValues[k];
+            c->nPossibilities = oc->nPossibilities;
+            c->orderPos = oc->orderPos;
+            p->cells[i][j] = c;
+        }
+    }
+
+    // Copiar o grafo de desigualdades, apontando para as novas células
+    p->nConstr = orig->nConstr;
+    p->greaterStart = malloc((nCells + 1) * sizeof(*p->greaterStart));
+    p->smallerStart = malloc((nCells + 1) * sizeof(*p->smallerStart));
+    memcpy(p->greaterStart, orig->greaterStart, (nCells + 1) * sizeof(*p->greaterStart));
+    memcpy(p->smallerStart, orig->smallerStart, (nCells + 1) * sizeof(*p->smallerStart));
+    p->greater = malloc((p->nConstr + 1) * sizeof(*p->greater));
+    p->smaller = malloc((p->nConstr + 1) * sizeof(*p->smaller));
+    for (n = 0; n < p->nConstr; n++) {
+        p->greater[n] = p->cells[orig->greater[n]->row][orig->greater[n]->col];
+        p->smaller[n] = p->cells[orig->smaller[n]->row][orig->smaller[n]->col];
+    }
+    for (n = 0; n < nCells; n++) {
+        c = p->cells[n / p->size][n % p->size];
+        c->greater = p->greater + p->greaterStart[n];
+        c->nGreater = p->greaterStart[n + 1] - p->greaterStart[n];
+        c->smaller = p->smaller + p->smallerStart[n];
+        c->nSmaller = p->smallerStart[n + 1] - p->smallerStart[n];
+    }
+
+    return p;
+}
+
+void puzzle_copyValues(Puzzle *dst, const Puzzle *src) {
+    uchar i, j;
+    Cell *c;
+
+    for (i = 0; i < dst->size; i++) {
+        for (j = 0; j < dst->size; j++) {
+            c = dst->cells[i][j];
+            _updateRestrictedValues(dst, c, src->cells[i][j]->val);
+            c->val = src->cells[i][j]->val;
+        }
+    }
+}
+
 void puzzle_destroy(Puzzle *p) {
     uchar i, j;
-    list_destroy(p->constrCells);
+
+    free(p->greaterStart);
+    free(p->greater);
+    free(p->smallerStart);
+    free(p->smaller);
 
     for (i = 0; i < p->size; i++) {
         for (j = 0; j < p->size; j++)
@@ -388,17 +793,19 @@ void puzzle_destroy(Puzzle *p) {
         free(p->cells[i]);
     }
     free(p->cells);
+    free(p->givens);
     free(p);
 }
 
 bool puzzle_checkSolved(Puzzle *p) {
     // Vetores que marcam quais valores já foram encontrados na linha/coluna i.
-    BitArray *numsInRow = bitarray_new(p->size);
-    BitArray *numsInCol = bitarray_new(p->size);
-    ListIterator *constrIter;
+    BitSet *numsInRow = bitset_new(p->size);
+    BitSet *numsInCol = bitset_new(p->size);
     Cell *c;
     uchar i, j;
     uchar v;
+    size_t n;
+    unsigned int k;
     bool valid = true;
 
     // Linha ou coluna atual sendo checada
@@ -411,17 +818,17 @@ bool puzzle_checkSolved(Puzzle *p) {
         j = 0;
 
         // Reset do vetor de booleanos
-        bitarray_clearAll(numsInRow);
-        bitarray_clearAll(numsInCol);
+        bitset_clearAll(numsInRow);
+        bitset_clearAll(numsInCol);
 
         while (valid && j < p->size) {
             v = p->cells[i][j]->val;
 
             if (v > 0) {
-                if (bitarray_check(numsInRow, v-1)) // Mesmo número já foi encontrado anteriormente na mesma linha
+                if (bitset_check(numsInRow, v-1)) // Mesmo número já foi encontrado anteriormente na mesma linha
                     valid = false;
                 else
-                    bitarray_set(numsInRow, v-1); // Setar como já encontrado
+                    bitset_set(numsInRow, v-1); // Setar como já encontrado
             } else {
                 valid = false;
             }
@@ -431,10 +838,10 @@ bool puzzle_checkSolved(Puzzle *p) {
 
             // Análogo, mas com i representando a coluna e não a linha
             if (v > 0) {
-                if (bitarray_check(numsInCol, v-1))
+                if (bitset_check(numsInCol, v-1))
                     valid = false;
                 else
-                    bitarray_set(numsInCol, v-1);
+                    bitset_set(numsInCol, v-1);
             } else {
                 valid = false;
             }
@@ -445,77 +852,342 @@ bool puzzle_checkSolved(Puzzle *p) {
         i++;
     }
 
-    bitarray_destroy(numsInRow);
-    bitarray_destroy(numsInCol);
+    bitset_destroy(numsInRow);
+    bitset_destroy(numsInCol);
 
-    constrIter = list_iterator(p->constrCells);
+    // Verificar se todas as limitações foram respeitadas (todas as células
+    // já estão preenchidas se a grade for válida até aqui)
+    for (n = 0; valid && n < (size_t) p->size * p->size; n++) {
+        c = p->cells[n / p->size][n % p->size];
+        for (k = 0; k < c->nGreater; k++)
+            if (c->val > c->greater[k]->val)
+                valid = false;
+    }
 
-    // Verificar se todas as limitações foram respeitadas
-    while (valid && listiter_hasNext(constrIter)) {
-        c = listiter_next(constrIter);
-        if (c->val > 0) {
-            for (i = 0; i < c->nConstr; i++)
-                if (c->val > c->constr[i]->val)
-                    valid = false;
-        } else {
-            valid = false;
-        }
+    return valid;
+}
+
+
+
+uint64_t futoshiki_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+// Salva o estado do nó em que a busca desiste por prazo ou limite, para que
+// possa ser continuada com limites maiores. Durante a reexecução de um
+// caminho salvo o arquivo ainda tem o estado anterior, que continua válido
+void _checkpoint_last(Search *s) {
+    if (s->opts->checkpoint != NULL && s->resume == NULL)
+        _checkpoint_write(s);
+}
+
+// Checagem periódica dos limites que não dependem do número de atribuições.
+// Retorna se a busca deve ser interrompida, registrando o motivo.
+bool _interrupted(Search *s) {
+    const SolveOptions *opts = s->opts;
+
+    s->untilCheck = s->checkInterval;
+
+    if ((opts->cancel != NULL && atomic_load_explicit(opts->cancel, memory_order_relaxed))
+            || (s->stop != NULL && atomic_load_explicit(s->stop, memory_order_relaxed))) {
+        s->status = SOLVE_CANCELLED;
+        return true;
+    }
+    if (opts->deadline != 0 && futoshiki_now() >= opts->deadline) {
+        s->status = SOLVE_TIMEOUT;
+        _checkpoint_last(s);
+        return true;
     }
 
-    listiter_destroy(constrIter);
+    // O estado é salvo na entrada de um nó, antes de testar seus valores
+    if (opts->checkpoint != NULL && s->resume == NULL && futoshiki_now() >= s->nextCheckpoint) {
+        _checkpoint_write(s);
+        s->nextCheckpoint = futoshiki_now() + opts->checkpointInterval;
+    }
+    return false;
+}
 
-    return valid;
+// Checagem de uma folha da árvore de busca (tabuleiro completo)
+bool _leafCheck(Search *s) {
+    bool solved;
+    uint64_t orbit = 1;
+
+    STATS_INC(s, leafChecks);
+    TIMER_START(t);
+    solved = puzzle_checkSolved(s->p);
+    TIMER_STOP(s, PHASE_LEAF_CHECK, t);
+    if (s->trace != NULL)
+        trace_record(s->trace, solved ? TRACE_SOLUTION : TRACE_LEAF_FAIL, s->depth, 0, 0, 0);
+    if (!solved)
+        STATS_INC(s, leafFailures);
+
+    // Na contagem, cada solução representa toda a sua órbita, e a busca
+    // continua como se a folha tivesse falhado
+    if (solved && s->counting) {
+        if (s->cfg->symmetryBreaking)
+            orbit = symmetry_orbit(s->p, &s->p->sym);
+        s->solutions = orbit > UINT64_MAX - s->solutions ? UINT64_MAX : s->solutions + orbit;
+        return false;
+    }
+    return solved;
 }
 
+// Retorna se a atribuição atual pode levar a uma solução que seja a menor
+// de sua órbita
+bool _symmetryAllowed(Search *s) {
+    if (symmetry_allowed(s->p, &s->p->sym))
+        return true;
+    STATS_INC(s, symmetryPrunes);
+    return false;
+}
 
+bool _backtrack(Search *, Cell *);
 
-Cell *_firstCell(Puzzle *p) {
-    uchar i, j;
+// Tenta cada valor possível de c, retornando se algum levou a uma solução
+bool _branch(Search *s, Cell *c) {
+    bool solved, more;
 
-#if OPT_LEVEL < OPT_MVR
-    // Procurar primeira célula vaga
-    for (i = 0; i < p->size; i++)
-        for (j = 0; j < p->size; j++)
-            if (p->cells[i][j]->val == 0)
-                return p->cells[i][j];
+    s->path[s->depth] = c;
 
-    return NULL;
-#else
-    // Procurar célula mais símples
-    uchar easiestComplexity = UCHAR_MAX;
-    Cell *easiest, *curr;
+    // Ao retomar uma busca salva, os níveis do caminho salvo começam pelo
+    // valor que estava em teste
+    more = s->resume != NULL ? _checkpoint_replay(s, c) : cell_nextValue(s, c);
+    for (; more; more = cell_nextValue(s, c)) {
+        if (s->cfg->symmetryBreaking && !_symmetryAllowed(s))
+            continue;
+        STATS_CHILD(s);
+        s->depth++;
+        solved = _backtrack(s, cell_nextInSeq(s, c));
+        s->depth--;
 
-    for (i = 0; i < p->size; i++) {
-        for (j = 0; j < p->size; j++) {
-            curr = p->cells[i][j];
-            if (curr->val == 0 && curr->nPossibilities < easiestComplexity) {
-                //fprintf(stderr, "easiestComplx: %hhu\n", curr->nPossibilities);
-                easiest = curr;
-                easiestComplexity = curr->nPossibilities;
-            }
+        if (solved)
+            return true;
+        // Busca interrompida em algum nível abaixo; a contagem devolve o
+        // tabuleiro como o recebeu mesmo assim
+        if (s->status != SOLVE_UNSAT) {
+            if (s->counting)
+                _cell_clear(s, c);
+            return false;
         }
     }
 
-    return easiest;
-#endif
+    // Um caminho salvo que não corresponde a esta busca a cancela sem
+    // tentar valor algum, o que nada diz sobre a grade
+    if (s->status != SOLVE_UNSAT)
+        return false;
+
+    // Todos os valores falharam sem interrupção: a grade não tem solução
+    if (s->table != NULL)
+        transtable_insert(s->table, s->hash);
+    STATS_INC(s, backtracks);
+    return false;
 }
 
-bool _backtrack(Puzzle *p, Cell *c, int *assignments) {
+bool _backtrack(Search *s, Cell *c) {
+    size_t mark;
+    bool solved;
+
     if (c == NULL)
-        return puzzle_checkSolved(p);
-    if (*assignments >= ASSIGN_MAX)
+        return _leafCheck(s);
+    if (*s->assignments >= s->opts->maxAssignments) {
+        s->status = SOLVE_LIMIT;
+        _checkpoint_last(s);
+        return false;
+    }
+    if (--s->untilCheck == 0 && _interrupted(s))
+        return false;
+    // O caminho salvo é refeito exatamente, mesmo que a tabela já tenha a
+    // grade de algum de seus nós
+    if (s->table != NULL && s->resume == NULL && transtable_contains(s->table, s->hash)) {
+        STATS_INC(s, transpositionHits);
         return false;
+    }
 
-    while (cell_nextValue(p, c, assignments)) {
-        if (_backtrack(p, cell_nextInSeq(p, c), assignments))
-            return true;
+    STATS_NODE(s);
+    if (s->depth >= s->cfg->probeDepth)
+        return _branch(s, c);
+
+    // Os valores descartados pela sondagem valem apenas abaixo deste nó
+    mark = s->nRemoved;
+    solved = _probe(s) && _branch(s, c);
+    _probe_undo(s, mark);
+    return solved;
+}
+
+// Preenche a ordem em que os valores serão testados segundo a configuração.
+void _fillValueOrder(uchar *order, uchar size, const SolverConfig *cfg) {
+    unsigned int rng = cfg->seed * 2654435761u + 1;
+    uchar i, j, tmp;
+
+    for (i = 0; i < size; i++) {
+        if (cfg->order == ORDER_DESCENDING)
+            order[i] = size - i;
+        else
+            order[i] = i + 1;
     }
 
-    return false;
+    if (cfg->order == ORDER_RANDOM) {
+        // Fisher-Yates com xorshift, para não depender do estado de rand()
+        for (i = size - 1; i > 0; i--) {
+            rng ^= rng << 13;
+            rng ^= rng >> 17;
+            rng ^= rng << 5;
+            j = rng % (i + 1);
+            tmp = order[i];
+            order[i] = order[j];
+            order[j] = tmp;
+        }
+    }
+}
+
+// Prepara uma busca sobre o tabuleiro com as opções dadas
+void _search_init(Search *s, Puzzle *p, const SolveOptions *opts, const atomic_bool *stop, int64_t *assignments) {
+    s->p = p;
+    s->opts = opts;
+    s->cfg = &opts->config;
+    s->stop = stop;
+    s->assignments = assignments;
+    s->status = SOLVE_UNSAT;
+    // Com 0 o contador daria a volta antes da primeira checagem
+    s->checkInterval = opts->checkInterval > 0 ? opts->checkInterval : 1;
+    s->untilCheck = s->checkInterval;
+    s->depth = 0;
+    s->stats = opts->stats;
+    s->trace = opts->trace;
+    if (s->stats != NULL)
+        solvestats_clear(s->stats);
+    s->kernel = searchkernel_get(p->size);
+    s->table = opts->transpositions;
+    s->hash = s->table != NULL ? _gridHash(p) : 0;
+    s->valueOrder = malloc(p->size * sizeof(*s->valueOrder));
+    _fillValueOrder(s->valueOrder, p->size, s->cfg);
+    s->counting = false;
+    s->solutions = 0;
+    s->probeStack = NULL;
+    s->removedCells = NULL;
+    s->removedVals = NULL;
+    s->nRemoved = 0;
+    s->removedCap = 0;
+    if (s->cfg->probeDepth > 0)
+        s->probeStack = malloc((size_t) p->size * p->size * sizeof(*s->probeStack));
+    s->path = malloc((size_t) p->size * p->size * sizeof(*s->path));
+    s->resume = opts->resume;
+    s->fingerprint = 0;
+    s->nextCheckpoint = 0;
+    if (opts->checkpoint != NULL) {
+        s->fingerprint = _checkpoint_fingerprint(p);
+        s->nextCheckpoint = futoshiki_now() + opts->checkpointInterval;
+    }
+}
+
+void _search_free(Search *s) {
+    free(s->valueOrder);
+    free(s->probeStack);
+    free(s->removedCells);
+    free(s->removedVals);
+    free(s->path);
+}
+
+SolveStatus _solve(Puzzle *p, const SolveOptions *opts, const atomic_bool *stop, int64_t *assignments) {
+    Search s;
+
+    _search_init(&s, p, opts, stop, assignments);
+    if (s.resume != NULL)
+        _checkpoint_begin(&s);
+
+    if (!p->unsat && s.status == SOLVE_UNSAT && _backtrack(&s, cell_nextInSeq(&s, NULL)))
+        s.status = SOLVE_SOLVED;
+
+    _search_free(&s);
+    return s.status;
 }
 
-bool puzzle_solve(Puzzle *p, int *assignments) {
-    return _backtrack(p, _firstCell(p), assignments);
+SolverConfig solverconfig_default(void) {
+    SolverConfig cfg;
+
+    cfg.forwardChecking = OPT_LEVEL >= OPT_FORWARD_CHECKING;
+    cfg.mvr = OPT_LEVEL >= OPT_MVR;
+    cfg.ineqCheck = false;
+    cfg.symmetryBreaking = false;
+    cfg.order = ORDER_ASCENDING;
+    cfg.seed = 0;
+    cfg.probeDepth = 0;
+    cfg.probeBudget = PROBE_BUDGET;
+
+    return cfg;
+}
+
+SolveOptions solveoptions_default(void) {
+    SolveOptions opts;
+
+    opts.config = solverconfig_default();
+    opts.maxAssignments = ASSIGN_MAX;
+    opts.deadline = 0;
+    opts.cancel = NULL;
+    opts.checkInterval = CHECK_INTERVAL;
+    opts.stats = NULL;
+    opts.trace = NULL;
+    opts.transpositions = NULL;
+    opts.checkpoint = NULL;
+    opts.checkpointInterval = CHECKPOINT_INTERVAL;
+    opts.checkpointTag = 0;
+    opts.resume = NULL;
+
+    return opts;
+}
+
+SolveStatus puzzle_solve(Puzzle *p, const SolveOptions *opts, int64_t *assignments) {
+    SolveOptions defaults;
+
+    if (opts == NULL) {
+        defaults = solveoptions_default();
+        opts = &defaults;
+    }
+    return _solve(p, opts, NULL, assignments);
+}
+
+SolveStatus puzzle_count(Puzzle *p, const SolveOptions *opts, uint64_t *count, int64_t *assignments) {
+    SolveOptions defaults;
+    Search s;
+
+    if (opts == NULL) {
+        defaults = solveoptions_default();
+        opts = &defaults;
+    }
+    _search_init(&s, p, opts, NULL, assignments);
+    s.counting = true;
+    s.table = NULL;
+    if (s.resume != NULL)
+        _checkpoint_begin(&s);
+
+    // Todas as folhas falham na contagem, e a busca termina com o tabuleiro
+    // em seu estado inicial
+    if (!p->unsat && s.status == SOLVE_UNSAT)
+        _backtrack(&s, cell_nextInSeq(&s, NULL));
+    if (s.status == SOLVE_UNSAT && s.solutions > 0)
+        s.status = SOLVE_SOLVED;
+
+    _search_free(&s);
+    *count = s.solutions;
+    return s.status;
+}
+
+const char *solvestatus_name(SolveStatus status) {
+    switch (status) {
+        case SOLVE_SOLVED:
+            return "solved";
+        case SOLVE_UNSAT:
+            return "unsat";
+        case SOLVE_LIMIT:
+            return "limit";
+        case SOLVE_TIMEOUT:
+            return "timeout";
+        case SOLVE_CANCELLED:
+            return "cancelled";
+    }
+    return "unknown";
 }
 
 void puzzle_display(const Puzzle *p, FILE *stream) {
@@ -0,0 +1,44 @@
+#include <stdbool.h>
+#include <limits.h>
+
+#include "core/puzzle.h"
+
+// Núcleos especializados para os tamanhos mais comuns
+#define KERNEL_N 4
+#include "core/kernel.h"
+#define KERNEL_N 5
+#include "core/kernel.h"
+#define KERNEL_N 6
+#include "core/kernel.h"
+#define KERNEL_N 7
+#include "core/kernel.h"
+#define KERNEL_N 8
+#include "core/kernel.h"
+#define KERNEL_N 9
+#include "core/kernel.h"
+
+// Núcleo para qualquer tamanho
+static const SearchKernel genericKernel = {
+    _updateRestrictedValues,
+    _cellsFeasible,
+    _mostConstrained
+};
+
+const SearchKernel *searchkernel_get(uchar size) {
+    switch (size) {
+        case 4:
+            return &searchKernel4;
+        case 5:
+            return &searchKernel5;
+        case 6:
+            return &searchKernel6;
+        case 7:
+            return &searchKernel7;
+        case 8:
+            return &searchKernel8;
+        case 9:
+            return &searchKernel9;
+        default:
+            return &genericKernel;
+    }
+}
@@ -0,0 +1,465 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#include "core/futoshiki.h"
+#include "core/puzzle.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LANES_AVX2 1
+#endif
+
+// Tabuleiros resolvidos juntos, um por faixa de 32 bits de um registrador AVX2
+#define LANES 8
+
+// Maior tamanho resolvido nas faixas
+#define LANES_MAX_SIZE 16
+
+// Níveis de ramificação feitos nas faixas; um tabuleiro que precise de mais
+// é passado à busca escalar
+#define LANES_MAX_DEPTH 8
+
+#define ALL_LANES ((1u << LANES) - 1)
+
+/*
+ * Tabuleiros de mesmo tamanho resolvidos em conjunto. O domínio de cada
+ * célula é uma máscara com o bit v - 1 setado se o valor v ainda é
+ * possível, guardada em dom[célula * LANES + faixa], de modo que os
+ * domínios de uma célula em todas as faixas formam um registrador.
+ */
+typedef struct LaneBatch {
+    size_t size;
+    size_t nCells;
+    const SolveOptions *opts;
+
+    Puzzle *puzzles[LANES];
+    uint32_t *dom;
+
+    // Domínios salvos ao ramificar, nCells * LANES por nível
+    uint32_t *stack;
+
+    // Células de cada linha e depois de cada coluna
+    size_t *lines;
+
+    // União das desigualdades das faixas: lo < hi nas faixas em que
+    // mask[par * LANES + faixa] é ~0
+    size_t nPairs;
+    size_t *lo;
+    size_t *hi;
+    uint32_t *mask;
+
+    // Faixas resolvidas e faixas que precisaram de ramificação demais
+    unsigned int solved;
+    unsigned int deep;
+    uchar *solutions;
+    int64_t assignments[LANES];
+
+    // Faixas que atingiram o limite de atribuições, e faixas ainda não
+    // decididas quando a busca foi interrompida, com o motivo da
+    // interrupção (SOLVE_UNSAT enquanto não houver)
+    unsigned int limited;
+    unsigned int stopped;
+    SolveStatus interrupted;
+} LaneBatch;
+
+#ifdef LANES_AVX2
+
+// Máscara com um bit por faixa em que v é zero
+__attribute__((target("avx2")))
+unsigned int _lanes_zero(__m256i v) {
+    v = _mm256_cmpeq_epi32(v, _mm256_setzero_si256());
+    return _mm256_movemask_ps(_mm256_castsi256_ps(v));
+}
+
+// Propaga até o ponto fixo: valores fixados saem das outras células da
+// linha e coluna, valores possíveis em uma só célula da linha são fixados
+// nela, e cada desigualdade limita o menor e o maior valor de suas
+// células. Retorna as faixas com alguma célula sem valores ou alguma linha
+// sem lugar para algum valor.
+__attribute__((target("avx2")))
+unsigned int _lanes_propagate(LaneBatch *b) {
+    __m256i *d = (__m256i *) b->dom;
+    const __m256i *m = (const __m256i *) b->mask;
+    size_t n = b->size, l, i, k;
+    const size_t *line;
+    __m256i one = _mm256_set1_epi32(1);
+    __m256i ones = _mm256_set1_epi32(-1);
+    __m256i full = _mm256_set1_epi32((int) ((1u << n) - 1));
+    __m256i single[LANES_MAX_SIZE], after[LANES_MAX_SIZE];
+    __m256i changed, failed, before, once, twice, hidden, x, y, s;
+
+    failed = _mm256_setzero_si256();
+    do {
+        changed = _mm256_setzero_si256();
+
+        for (l = 0; l < 2 * n; l++) {
+            line = &b->lines[l * n];
+
+            // Valores fixados em cada célula (0 se houver mais de um) e OU
+            // dos fixados nas células seguintes
+            for (i = 0; i < n; i++) {
+                x = d[line[i]];
+                y = _mm256_and_si256(x, _mm256_sub_epi32(x, one));
+                single[i] = _mm256_andnot_si256(_mm256_cmpeq_epi32(y, _mm256_setzero_si256()), ones);
+                single[i] = _mm256_andnot_si256(single[i], x);
+            }
+            after[n - 1] = _mm256_setzero_si256();
+            for (i = n - 1; i > 0; i--)
+                after[i - 1] = _mm256_or_si256(after[i], single[i]);
+
+            before = _mm256_setzero_si256();
+            once = _mm256_setzero_si256();
+            twice = _mm256_setzero_si256();
+            for (i = 0; i < n; i++) {
+                x = d[line[i]];
+                y = _mm256_andnot_si256(_mm256_or_si256(before, after[i]), x);
+                before = _mm256_or_si256(before, single[i]);
+                changed = _mm256_or_si256(changed, _mm256_xor_si256(x, y));
+                d[line[i]] = y;
+
+                twice = _mm256_or_si256(twice, _mm256_and_si256(once, y));
+                once = _mm256_or_si256(once, y);
+            }
+
+            // Valor sem lugar na linha
+            failed = _mm256_or_si256(failed, _mm256_xor_si256(once, full));
+
+            // Valores possíveis em uma só célula
+            hidden = _mm256_andnot_si256(twice, once);
+            for (i = 0; i < n; i++) {
+                x = d[line[i]];
+                y = _mm256_and_si256(x, hidden);
+                s = _mm256_cmpeq_epi32(y, _mm256_setzero_si256());
+                y = _mm256_blendv_epi8(y, x, s);
+                changed = _mm256_or_si256(changed, _mm256_xor_si256(x, y));
+                d[line[i]] = y;
+            }
+        }
+
+        for (k = 0; k < b->nPairs; k++) {
+            x = d[b->lo[k]];
+            y = d[b->hi[k]];
+
+            // hi acima do menor valor de lo: apagar os bits até o menor bit
+            // setado de x, que são x ^ (x - 1)
+            s = _mm256_xor_si256(x, _mm256_sub_epi32(x, one));
+            s = _mm256_and_si256(s, m[k]);
+            changed = _mm256_or_si256(changed, _mm256_and_si256(y, s));
+            y = _mm256_andnot_si256(s, y);
+            d[b->hi[k]] = y;
+
+            // lo abaixo do maior valor de hi: espalhar o maior bit setado
+            // de y para baixo e descartar o próprio bit
+            s = _mm256_or_si256(y, _mm256_srli_epi32(y, 1));
+            s = _mm256_or_si256(s, _mm256_srli_epi32(s, 2));
+            s = _mm256_or_si256(s, _mm256_srli_epi32(s, 4));
+            s = _mm256_or_si256(s, _mm256_srli_epi32(s, 8));
+            s = _mm256_srli_epi32(s, 1);
+            s = _mm256_or_si256(s, _mm256_andnot_si256(m[k], ones));
+            changed = _mm256_or_si256(changed, _mm256_andnot_si256(s, x));
+            d[b->lo[k]] = _mm256_and_si256(x, s);
+        }
+
+        // Faixas que falharam param de mudar logo, pois zeram suas células
+    } while (_lanes_zero(changed) != ALL_LANES);
+
+    for (i = 0; i < b->nCells; i++)
+        failed = _mm256_or_si256(failed, _mm256_cmpeq_epi32(d[i], _mm256_setzero_si256()));
+    return ~_lanes_zero(failed) & ALL_LANES;
+}
+
+// Faixas em que toda célula tem um único valor
+__attribute__((target("avx2")))
+unsigned int _lanes_solved(LaneBatch *b) {
+    const __m256i *d = (const __m256i *) b->dom;
+    __m256i one = _mm256_set1_epi32(1);
+    __m256i multi = _mm256_setzero_si256();
+    size_t i;
+
+    for (i = 0; i < b->nCells; i++)
+        multi = _mm256_or_si256(multi, _mm256_and_si256(d[i], _mm256_sub_epi32(d[i], one)));
+    return _lanes_zero(multi);
+}
+
+// Guarda a grade da faixa resolvida
+void _lanes_record(LaneBatch *b, int lane) {
+    size_t i;
+
+    for (i = 0; i < b->nCells; i++)
+        b->solutions[lane * b->nCells + i] = __builtin_ctz(b->dom[i * LANES + lane]) + 1;
+    b->solved |= 1u << lane;
+}
+
+// Retorna se o prazo ou o cancelamento das opções interrompem a busca,
+// registrando o motivo
+bool _lanes_interrupted(LaneBatch *b) {
+    const SolveOptions *opts = b->opts;
+
+    if (b->interrupted == SOLVE_UNSAT) {
+        if (opts->cancel != NULL && atomic_load_explicit(opts->cancel, memory_order_relaxed))
+            b->interrupted = SOLVE_CANCELLED;
+        else if (opts->deadline != 0 && futoshiki_now() >= opts->deadline)
+            b->interrupted = SOLVE_TIMEOUT;
+    }
+    return b->interrupted != SOLVE_UNSAT;
+}
+
+// Busca em profundidade sincronizada: no nível depth, cada faixa de active
+// ramifica na sua célula com menos valores possíveis, e as faixas tentam
+// juntas o primeiro valor de suas células, depois o segundo e assim por
+// diante. Faixas resolvidas, profundas demais ou sem atribuições restantes
+// deixam de participar. Prazo e cancelamento são checados a cada nível, e
+// numa interrupção as faixas com valores ainda por tentar em algum nível
+// ficam sem decisão.
+void _lanes_search(LaneBatch *b, unsigned int active, unsigned int depth) {
+    size_t nCells = b->nCells, i, cell[LANES];
+    uint32_t *saved = b->stack + depth * nCells * LANES;
+    uint32_t vals[LANES], d, bit;
+    unsigned int tried, failed, solved, next;
+    int lane, count, best;
+
+    if (_lanes_interrupted(b)) {
+        b->stopped |= active;
+        return;
+    }
+    if (depth == LANES_MAX_DEPTH) {
+        b->deep |= active;
+        return;
+    }
+
+    for (lane = 0; lane < LANES; lane++) {
+        if (!(active & (1u << lane)))
+            continue;
+        best = INT32_MAX;
+        for (i = 0; i < nCells; i++) {
+            d = b->dom[i * LANES + lane];
+            count = __builtin_popcount(d);
+            if (count > 1 && count < best) {
+                best = count;
+                cell[lane] = i;
+            }
+        }
+        vals[lane] = b->dom[cell[lane] * LANES + lane];
+    }
+    memcpy(saved, b->dom, nCells * LANES * sizeof(*saved));
+
+    while (true) {
+        active &= ~(b->solved | b->deep | b->limited);
+        tried = 0;
+        for (lane = 0; lane < LANES; lane++) {
+            if (!(active & (1u << lane)) || vals[lane] == 0)
+                continue;
+            if (b->assignments[lane] >= b->opts->maxAssignments) {
+                b->limited |= 1u << lane;
+                continue;
+            }
+            bit = vals[lane] & -vals[lane];
+            vals[lane] &= ~bit;
+            b->dom[cell[lane] * LANES + lane] = bit;
+            b->assignments[lane]++;
+            tried |= 1u << lane;
+        }
+        if (tried == 0)
+            break;
+
+        failed = _lanes_propagate(b);
+        solved = _lanes_solved(b) & tried & ~failed;
+        for (lane = 0; lane < LANES; lane++)
+            if (solved & (1u << lane))
+                _lanes_record(b, lane);
+
+        next = tried & ~failed & ~solved;
+        if (next != 0)
+            _lanes_search(b, next, depth + 1);
+        memcpy(b->dom, saved, nCells * LANES * sizeof(*saved));
+
+        // Os níveis abaixo já registraram as faixas que exploravam
+        if (b->interrupted != SOLVE_UNSAT) {
+            for (lane = 0; lane < LANES; lane++)
+                if ((active & (1u << lane)) && vals[lane] != 0)
+                    b->stopped |= 1u << lane;
+            return;
+        }
+    }
+}
+
+// Carrega até LANES tabuleiros de mesmo tamanho nas faixas; faixas sem
+// tabuleiro ficam sem valores e falham na primeira propagação
+void _lanes_load(LaneBatch *b, Puzzle **ps, int count, int32_t *pairIndex) {
+    size_t n = b->size, i, k;
+    unsigned int j;
+    Puzzle *p;
+    Cell *c;
+    int lane;
+    uchar v;
+
+    memset(b->dom, 0, b->nCells * LANES * sizeof(*b->dom));
+    b->nPairs = 0;
+    b->solved = 0;
+    b->deep = 0;
+    b->limited = 0;
+    b->stopped = 0;
+    b->interrupted = SOLVE_UNSAT;
+
+    for (lane = 0; lane < count; lane++) {
+        p = b->puzzles[lane] = ps[lane];
+        b->assignments[lane] = 0;
+        if (p->unsat)
+            continue;
+        for (i = 0; i < b->nCells; i++) {
+            c = p->cells[i / n][i % n];
+            if (c->val > 0) {
+                b->dom[i * LANES + lane] = 1u << (c->val - 1);
+                continue;
+            }
+            for (v = 0; v < n; v++)
+                if (c->restrictedValues[v] == 0)
+                    b->dom[i * LANES + lane] |= 1u << v;
+        }
+
+        for (i = 0; i < b->nCells; i++) {
+            c = p->cells[i / n][i % n];
+            for (j = 0; j < c->nGreater; j++) {
+                k = i * b->nCells + CELL_INDEX(p, c->greater[j]);
+                if (pairIndex[k] < 0) {
+                    pairIndex[k] = b->nPairs;
+                    b->lo[b->nPairs] = i;
+                    b->hi[b->nPairs] = CELL_INDEX(p, c->greater[j]);
+                    memset(&b->mask[b->nPairs * LANES], 0, LANES * sizeof(*b->mask));
+                    b->nPairs++;
+                }
+                b->mask[pairIndex[k] * LANES + lane] = UINT32_MAX;
+            }
+        }
+    }
+    for (; lane < LANES; lane++)
+        b->puzzles[lane] = NULL;
+
+    for (k = 0; k < b->nPairs; k++)
+        pairIndex[b->lo[k] * b->nCells + b->hi[k]] = -1;
+}
+
+// Atribui a solução da faixa ao tabuleiro, mantendo seus contadores
+void _lanes_store(LaneBatch *b, int lane) {
+    Puzzle *p = b->puzzles[lane];
+    const SearchKernel *kernel = searchkernel_get(p->size);
+    size_t i;
+    Cell *c;
+
+    for (i = 0; i < b->nCells; i++) {
+        c = p->cells[i / b->size][i % b->size];
+        if (c->val == 0) {
+            kernel->update(p, c, b->solutions[lane * b->nCells + i]);
+            c->val = b->solutions[lane * b->nCells + i];
+        }
+    }
+}
+
+// Resolve nas faixas os tabuleiros de ps[0..count - 1], todos de tamanho
+// size, passando os que ramificam demais a puzzle_solve
+void _lanes_solve(uchar size, Puzzle **ps, size_t count, const SolveOptions *opts,
+        SolveStatus *status, int64_t *assignments) {
+    LaneBatch b;
+    size_t g, i, nConstr = 0, maxPairs;
+    int32_t *pairIndex;
+    unsigned int failed, solved;
+    int lane, width;
+    int64_t a;
+
+    b.size = size;
+    b.nCells = (size_t) size * size;
+    b.opts = opts;
+    b.dom = aligned_alloc(32, b.nCells * LANES * sizeof(*b.dom));
+    b.stack = malloc(LANES_MAX_DEPTH * b.nCells * LANES * sizeof(*b.stack));
+    b.solutions = malloc(LANES * b.nCells);
+    b.lines = malloc(2 * b.nCells * sizeof(*b.lines));
+    for (i = 0; i < size; i++) {
+        for (g = 0; g < size; g++) {
+            b.lines[i * size + g] = i * size + g;
+            b.lines[(size + i) * size + g] = g * size + i;
+        }
+    }
+
+    for (g = 0; g < count; g++)
+        nConstr = ps[g]->nConstr > nConstr ? ps[g]->nConstr : nConstr;
+    maxPairs = LANES * nConstr + 1;
+    b.lo = malloc(maxPairs * sizeof(*b.lo));
+    b.hi = malloc(maxPairs * sizeof(*b.hi));
+    b.mask = aligned_alloc(32, maxPairs * LANES * sizeof(*b.mask));
+    pairIndex = malloc(b.nCells * b.nCells * sizeof(*pairIndex));
+    memset(pairIndex, -1, b.nCells * b.nCells * sizeof(*pairIndex));
+
+    for (g = 0; g < count; g += width) {
+        width = count - g < LANES ? count - g : LANES;
+        _lanes_load(&b, ps + g, width, pairIndex);
+
+        failed = _lanes_propagate(&b);
+        solved = _lanes_solved(&b) & ~failed;
+        for (lane = 0; lane < width; lane++)
+            if (solved & (1u << lane))
+                _lanes_record(&b, lane);
+        if ((solved | failed) != ALL_LANES)
+            _lanes_search(&b, ALL_LANES & ~(solved | failed), 0);
+
+        for (lane = 0; lane < width; lane++) {
+            a = b.assignments[lane];
+            if (b.solved & (1u << lane)) {
+                _lanes_store(&b, lane);
+                status[g + lane] = SOLVE_SOLVED;
+            } else if (b.limited & (1u << lane)) {
+                status[g + lane] = SOLVE_LIMIT;
+            } else if (b.stopped & (1u << lane)) {
+                status[g + lane] = b.interrupted;
+            } else if (b.deep & (1u << lane)) {
+                status[g + lane] = puzzle_solve(ps[g + lane], opts, &a);
+            } else {
+                status[g + lane] = SOLVE_UNSAT;
+            }
+            assignments[g + lane] += a;
+        }
+    }
+
+    free(pairIndex);
+    free(b.mask);
+    free(b.hi);
+    free(b.lo);
+    free(b.lines);
+    free(b.solutions);
+    free(b.stack);
+    free(b.dom);
+}
+
+#endif
+
+size_t puzzle_solveBatch(Puzzle **ps, size_t count, const SolveOptions *opts,
+        SolveStatus *status, int64_t *assignments) {
+    SolveOptions defaults;
+    size_t g = 0, end, nSolved = 0;
+
+    if (opts == NULL) {
+        defaults = solveoptions_default();
+        opts = &defaults;
+    }
+
+    while (g < count) {
+        // Trecho de tabuleiros consecutivos de mesmo tamanho
+        for (end = g + 1; end < count && ps[end]->size == ps[g]->size; end++)
+            ;
+
+#ifdef LANES_AVX2
+        if (ps[g]->size <= LANES_MAX_SIZE && __builtin_cpu_supports("avx2")) {
+            _lanes_solve(ps[g]->size, ps + g, end - g, opts, status + g, assignments + g);
+            g = end;
+        }
+#endif
+        for (; g < end; g++)
+            status[g] = puzzle_solve(ps[g], opts, &assignments[g]);
+    }
+
+    for (g = 0; g < count; g++)
+        nSolved += status[g] == SOLVE_SOLVED;
+    return nSolved;
+}
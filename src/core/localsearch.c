@@ -0,0 +1,430 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "core/futoshiki.h"
+#include "core/puzzle.h"
+
+// Porcentagem dos passos que trocam duas células ao acaso em vez de fazer a
+// melhor troca. Mais passos aleatórios e proibições mais longas atrasaram a
+// convergência em grades geradas de 20 a 80 células por lado.
+#define LOCAL_WALK 1
+
+// Passos durante os quais as células de uma troca que aumentou o custo não
+// podem voltar aos valores que deixaram
+#define LOCAL_TENURE 1
+
+// Passos sem melhorar o menor custo da tentativa, por célula livre, antes de
+// recomeçar de outra permutação
+#define LOCAL_STALL 64
+
+#define LOCAL_NONE ((size_t) -1)
+
+/*
+ * Estado da busca local. Cada linha é sempre uma permutação de 1..size que
+ * mantém os valores dados, então só colunas e desigualdades podem ter
+ * conflitos. O custo é o número de pares de células de uma mesma coluna com
+ * o mesmo valor mais o número de desigualdades violadas, e conflicts[i] é
+ * quantos desses pares e desigualdades incluem a célula i.
+ */
+typedef struct LocalSearch {
+    Puzzle *p;
+    size_t size;
+    size_t nCells;
+
+    uchar *val;
+
+    // Células dadas e células únicas livres em sua linha, cujo valor é
+    // forçado pela permutação
+    bool *fixed;
+    size_t nFree;
+
+    // colCount[coluna * (size + 1) + v]: células da coluna com valor v
+    unsigned int *colCount;
+    int *conflicts;
+    long cost;
+
+    // Células não fixas com algum conflito, e a posição de cada célula em
+    // conflicted (LOCAL_NONE se não está lá)
+    size_t *conflicted;
+    size_t nConflicted;
+    size_t *conflictPos;
+
+    // tabu[i * (size + 1) + v]: passo a partir do qual a célula i pode
+    // voltar a receber v
+    uint32_t *tabu;
+    uint32_t step;
+
+    // Valores que faltam na linha sendo preenchida
+    uchar *pool;
+
+    uint64_t rng;
+} LocalSearch;
+
+// Número aleatório em [0, n), por xorshift64*
+size_t _local_random(LocalSearch *L, size_t n) {
+    L->rng ^= L->rng >> 12;
+    L->rng ^= L->rng << 25;
+    L->rng ^= L->rng >> 27;
+    return ((L->rng * 2685821657736338717ull) >> 32) % n;
+}
+
+// Põe ou tira a célula do conjunto de células em conflito
+void _local_mark(LocalSearch *L, size_t i) {
+    bool in = L->conflictPos[i] != LOCAL_NONE;
+    size_t last;
+
+    if (L->fixed[i] || in == (L->conflicts[i] > 0))
+        return;
+
+    if (!in) {
+        L->conflictPos[i] = L->nConflicted;
+        L->conflicted[L->nConflicted++] = i;
+    } else {
+        last = L->conflicted[--L->nConflicted];
+        L->conflicted[L->conflictPos[i]] = last;
+        L->conflictPos[last] = L->conflictPos[i];
+        L->conflictPos[i] = LOCAL_NONE;
+    }
+}
+
+// Soma d ao conflito entre as células i e j
+void _local_adjust(LocalSearch *L, size_t i, size_t j, int d) {
+    L->conflicts[i] += d;
+    L->conflicts[j] += d;
+    L->cost += d;
+    _local_mark(L, j);
+}
+
+// Dá o valor v à célula i, atualizando contagens e conflitos
+void _local_set(LocalSearch *L, size_t i, uchar v) {
+    Puzzle *p = L->p;
+    size_t col = i % L->size, k, e;
+    unsigned int *count = L->colCount + col * (L->size + 1);
+    uchar old = L->val[i];
+
+    // Pares da coluna desfeitos com o valor antigo e formados com o novo
+    for (k = col; k < L->nCells; k += L->size) {
+        if (k == i)
+            continue;
+        if (L->val[k] == old)
+            _local_adjust(L, i, k, -1);
+        else if (L->val[k] == v)
+            _local_adjust(L, i, k, 1);
+    }
+    count[old]--;
+    count[v]++;
+
+    for (e = p->greaterStart[i]; e < p->greaterStart[i + 1]; e++) {
+        k = CELL_INDEX(p, p->greater[e]);
+        if ((L->val[k] <= old) != (L->val[k] <= v))
+            _local_adjust(L, i, k, L->val[k] <= v ? 1 : -1);
+    }
+    for (e = p->smallerStart[i]; e < p->smallerStart[i + 1]; e++) {
+        k = CELL_INDEX(p, p->smaller[e]);
+        if ((L->val[k] >= old) != (L->val[k] >= v))
+            _local_adjust(L, i, k, L->val[k] >= v ? 1 : -1);
+    }
+
+    L->val[i] = v;
+    _local_mark(L, i);
+}
+
+// Desigualdades da célula i violadas se ela tiver o valor v e a célula j o
+// valor w; com w igual a 0 as desigualdades entre i e j são ignoradas
+int _local_edges(const LocalSearch *L, size_t i, uchar v, size_t j, uchar w) {
+    const Puzzle *p = L->p;
+    size_t e, k;
+    uchar u;
+    int n = 0;
+
+    for (e = p->greaterStart[i]; e < p->greaterStart[i + 1]; e++) {
+        k = CELL_INDEX(p, p->greater[e]);
+        u = k == j ? w : L->val[k];
+        n += u != 0 && u <= v;
+    }
+    for (e = p->smallerStart[i]; e < p->smallerStart[i + 1]; e++) {
+        k = CELL_INDEX(p, p->smaller[e]);
+        u = k == j ? w : L->val[k];
+        n += u != 0 && u >= v;
+    }
+    return n;
+}
+
+// Variação do custo ao trocar os valores das células a e b, de colunas
+// diferentes de uma mesma linha
+long _local_delta(const LocalSearch *L, size_t a, size_t b) {
+    const unsigned int *ca = L->colCount + (a % L->size) * (L->size + 1);
+    const unsigned int *cb = L->colCount + (b % L->size) * (L->size + 1);
+    uchar va = L->val[a], vb = L->val[b];
+    long d;
+
+    d = (long) ca[vb] - (ca[va] - 1) + (long) cb[va] - (cb[vb] - 1);
+    d += _local_edges(L, a, vb, b, va) + _local_edges(L, b, va, a, 0);
+    d -= _local_edges(L, a, va, b, vb) + _local_edges(L, b, vb, a, 0);
+    return d;
+}
+
+// Célula livre da linha de a, diferente de a, sorteada
+size_t _local_walk(LocalSearch *L, size_t a) {
+    size_t row = a - a % L->size, k, chosen = LOCAL_NONE, seen = 0;
+
+    for (k = row; k < row + L->size; k++)
+        if (k != a && !L->fixed[k] && _local_random(L, ++seen) == 0)
+            chosen = k;
+    return chosen;
+}
+
+// Célula da linha de a com que trocar seu valor: a troca que mais reduz o
+// custo entre as não proibidas, ou que melhora o menor custo da tentativa,
+// com empates sorteados
+size_t _local_choose(LocalSearch *L, size_t a, long best) {
+    size_t row = a - a % L->size, stride = L->size + 1, k, chosen = LOCAL_NONE, ties = 0;
+    long d, min = 0;
+    bool tabu;
+
+    if (_local_random(L, 100) < LOCAL_WALK)
+        return _local_walk(L, a);
+
+    for (k = row; k < row + L->size; k++) {
+        if (k == a || L->fixed[k])
+            continue;
+        d = _local_delta(L, a, k);
+        tabu = L->tabu[a * stride + L->val[k]] > L->step
+                || L->tabu[k * stride + L->val[a]] > L->step;
+        if (tabu && L->cost + d >= best)
+            continue;
+        if (chosen == LOCAL_NONE || d < min) {
+            chosen = k;
+            min = d;
+            ties = 1;
+        } else if (d == min && _local_random(L, ++ties) == 0) {
+            chosen = k;
+        }
+    }
+
+    return chosen != LOCAL_NONE ? chosen : _local_walk(L, a);
+}
+
+// Troca os valores de a e b. Só as trocas que pioram o tabuleiro são
+// proibidas de ser desfeitas, para que a busca não volte logo ao mínimo
+// local de que acabou de sair.
+void _local_swap(LocalSearch *L, size_t a, size_t b) {
+    size_t stride = L->size + 1;
+    uchar va = L->val[a], vb = L->val[b];
+    long before = L->cost;
+
+    L->step++;
+    _local_set(L, a, vb);
+    _local_set(L, b, va);
+
+    if (L->cost > before) {
+        L->tabu[a * stride + va] = L->step + LOCAL_TENURE;
+        L->tabu[b * stride + vb] = L->step + LOCAL_TENURE;
+    }
+}
+
+// Preenche cada linha com uma permutação aleatória dos valores que faltam
+// nela, preferindo para cada célula os valores ainda possíveis no tabuleiro,
+// e recalcula todos os conflitos
+void _local_restart(LocalSearch *L) {
+    Puzzle *p = L->p;
+    size_t size = L->size, r, k, e, j, nPool, nAllowed, pick;
+    unsigned int *count;
+    Cell *c;
+    uchar v;
+
+    for (r = 0; r < size; r++) {
+        nPool = 0;
+        for (v = 1; v <= size; v++) {
+            for (k = 0; k < size && p->cells[r][k]->val != v; k++);
+            if (k == size)
+                L->pool[nPool++] = v;
+        }
+
+        for (k = 0; k < size; k++) {
+            c = p->cells[r][k];
+            if (c->val != 0)
+                continue;
+
+            // Sorteio entre os valores possíveis, ou entre todos se não houver
+            nAllowed = 0;
+            for (j = 0; j < nPool; j++)
+                nAllowed += c->restrictedValues[L->pool[j] - 1] == 0;
+            pick = _local_random(L, nAllowed > 0 ? nAllowed : nPool);
+            for (j = 0; nAllowed > 0 && (c->restrictedValues[L->pool[j] - 1] != 0 || pick-- > 0); j++);
+            if (nAllowed == 0)
+                j = pick;
+
+            L->val[r * size + k] = L->pool[j];
+            L->pool[j] = L->pool[--nPool];
+        }
+    }
+
+    memset(L->colCount, 0, size * (size + 1) * sizeof(*L->colCount));
+    memset(L->conflicts, 0, L->nCells * sizeof(*L->conflicts));
+    memset(L->tabu, 0, L->nCells * (size + 1) * sizeof(*L->tabu));
+    L->cost = 0;
+    L->step = 0;
+
+    for (k = 0; k < L->nCells; k++) {
+        count = L->colCount + (k % size) * (size + 1);
+        for (j = k % size; j < k; j += size) {
+            if (L->val[j] == L->val[k]) {
+                L->conflicts[j]++;
+                L->conflicts[k]++;
+                L->cost++;
+            }
+        }
+        count[L->val[k]]++;
+
+        // Cada desigualdade é contada a partir da menor célula
+        for (e = p->greaterStart[k]; e < p->greaterStart[k + 1]; e++) {
+            j = CELL_INDEX(p, p->greater[e]);
+            if (L->val[j] <= L->val[k]) {
+                L->conflicts[j]++;
+                L->conflicts[k]++;
+                L->cost++;
+            }
+        }
+    }
+
+    L->nConflicted = 0;
+    for (k = 0; k < L->nCells; k++) {
+        L->conflictPos[k] = LOCAL_NONE;
+        _local_mark(L, k);
+    }
+}
+
+void _local_init(LocalSearch *L, Puzzle *p, const SolverConfig *cfg) {
+    size_t r, k, nFree, last = 0;
+
+    L->p = p;
+    L->size = p->size;
+    L->nCells = L->size * L->size;
+    L->val = malloc(L->nCells * sizeof(*L->val));
+    L->fixed = malloc(L->nCells * sizeof(*L->fixed));
+    L->colCount = malloc(L->size * (L->size + 1) * sizeof(*L->colCount));
+    L->conflicts = malloc(L->nCells * sizeof(*L->conflicts));
+    L->conflicted = malloc(L->nCells * sizeof(*L->conflicted));
+    L->conflictPos = malloc(L->nCells * sizeof(*L->conflictPos));
+    L->tabu = malloc(L->nCells * (L->size + 1) * sizeof(*L->tabu));
+    L->pool = malloc(L->size * sizeof(*L->pool));
+    L->rng = (cfg->seed + 1) * 0x9E3779B97F4A7C15ull;
+
+    // Uma célula livre sozinha em sua linha nunca troca de valor
+    L->nFree = 0;
+    for (r = 0; r < L->size; r++) {
+        nFree = 0;
+        for (k = r * L->size; k < (r + 1) * L->size; k++) {
+            L->val[k] = p->cells[r][k % L->size]->val;
+            L->fixed[k] = L->val[k] != 0;
+            if (!L->fixed[k]) {
+                nFree++;
+                last = k;
+            }
+        }
+        if (nFree == 1)
+            L->fixed[last] = true;
+        else
+            L->nFree += nFree;
+    }
+}
+
+void _local_free(LocalSearch *L) {
+    free(L->val);
+    free(L->fixed);
+    free(L->colCount);
+    free(L->conflicts);
+    free(L->conflicted);
+    free(L->conflictPos);
+    free(L->tabu);
+    free(L->pool);
+}
+
+SolveStatus puzzle_solveLocal(Puzzle *p, const SolveOptions *opts, int64_t *assignments) {
+    SolveOptions defaults;
+    LocalSearch L;
+    SolveStatus status = SOLVE_SOLVED;
+    const SearchKernel *kernel;
+    unsigned int checkInterval, untilCheck;
+    uint64_t stall = 0;
+    long best;
+    size_t a, b, i;
+    Cell *c;
+
+    if (opts == NULL) {
+        defaults = solveoptions_default();
+        opts = &defaults;
+    }
+    if (p->unsat)
+        return SOLVE_UNSAT;
+
+    _local_init(&L, p, &opts->config);
+    _local_restart(&L);
+    best = L.cost;
+    checkInterval = opts->checkInterval > 0 ? opts->checkInterval : 1;
+    untilCheck = checkInterval;
+
+    while (L.cost > 0) {
+        // Conflitos só entre células fixas: os valores dados se contradizem
+        if (L.nConflicted == 0) {
+            status = SOLVE_UNSAT;
+            break;
+        }
+        if (*assignments >= opts->maxAssignments) {
+            status = SOLVE_LIMIT;
+            break;
+        }
+        if (--untilCheck == 0) {
+            untilCheck = checkInterval;
+            if (opts->cancel != NULL && atomic_load_explicit(opts->cancel, memory_order_relaxed)) {
+                status = SOLVE_CANCELLED;
+                break;
+            }
+            if (opts->deadline != 0 && futoshiki_now() >= opts->deadline) {
+                status = SOLVE_TIMEOUT;
+                break;
+            }
+        }
+
+        if (stall >= LOCAL_STALL * L.nFree) {
+            _local_restart(&L);
+            best = L.cost;
+            stall = 0;
+            continue;
+        }
+
+        a = L.conflicted[_local_random(&L, L.nConflicted)];
+        b = _local_choose(&L, a, best);
+        _local_swap(&L, a, b);
+        *assignments += 2;
+
+        if (L.cost < best) {
+            best = L.cost;
+            stall = 0;
+        } else {
+            stall++;
+        }
+    }
+
+    if (status == SOLVE_SOLVED) {
+        kernel = searchkernel_get(p->size);
+        for (i = 0; i < L.nCells; i++) {
+            c = p->cells[i / L.size][i % L.size];
+            if (c->val == 0) {
+                kernel->update(p, c, L.val[i]);
+                c->val = L.val[i];
+            }
+        }
+
+        // Custo zero deve ser uma solução; a checagem completa protege
+        // contra erros na contagem incremental
+        if (!puzzle_checkSolved(p))
+            status = SOLVE_LIMIT;
+    }
+
+    _local_free(&L);
+    return status;
+}
@@ -0,0 +1,145 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "core/futoshiki.h"
+#include "core/puzzle.h"
+#include "core/stats.h"
+
+typedef struct Portfolio Portfolio;
+
+typedef struct Worker {
+    Portfolio *shared;
+
+    // Cópia do tabuleiro usada exclusivamente por esta thread
+    Puzzle *p;
+    SolveOptions opts;
+
+    int64_t assignments;
+    SolveStatus status;
+
+    // Estatísticas desta thread, se pedidas pelo chamador
+    SolveStats stats;
+
+    // Se esta thread foi a primeira a terminar sua busca
+    bool decided;
+
+    pthread_t thread;
+} Worker;
+
+struct Portfolio {
+    // Setada pela primeira thread a terminar sua busca (com ou sem solução)
+    atomic_bool done;
+};
+
+// Configuração da k-ésima cópia do portfólio, derivada da configuração base.
+// As primeiras cópias usam estratégias distintas; as restantes variam
+// apenas a semente de uma ordem aleatória de valores.
+void _portfolioConfig(int k, const SolverConfig *base, SolverConfig *cfg) {
+    *cfg = *base;
+
+    switch (k) {
+        case 0:
+            break;
+        case 1:
+            cfg->ineqCheck = true;
+            break;
+        case 2:
+            cfg->ineqCheck = true;
+            cfg->order = ORDER_DESCENDING;
+            break;
+        case 3:
+            cfg->mvr = false;
+            cfg->ineqCheck = true;
+            break;
+        default:
+            cfg->ineqCheck = true;
+            cfg->order = ORDER_RANDOM;
+            cfg->seed = base->seed + k;
+            break;
+    }
+}
+
+void *_portfolioWorker(void *arg) {
+    Worker *w = arg;
+
+    w->status = _solve(w->p, &w->opts, &w->shared->done, &w->assignments);
+
+    // Tanto uma solução quanto uma prova de que não há solução encerram o
+    // portfólio; apenas a primeira thread a terminar publica seu resultado.
+    if (w->status == SOLVE_SOLVED || w->status == SOLVE_UNSAT)
+        w->decided = !atomic_exchange(&w->shared->done, true);
+
+    return NULL;
+}
+
+SolveStatus puzzle_solvePortfolio(Puzzle *p, const SolveOptions *opts, int nThreads, int64_t *assignments) {
+    Portfolio shared;
+    SolveOptions defaults;
+    Worker *workers;
+    Worker *decider = NULL;
+    SolveStatus status = SOLVE_LIMIT;
+    int64_t maxAssignments = 0;
+    int i;
+
+    if (opts == NULL) {
+        defaults = solveoptions_default();
+        opts = &defaults;
+    }
+    // Tabuleiros já provados sem solução não precisam de threads
+    if (nThreads <= 1 || p->unsat)
+        return puzzle_solve(p, opts, assignments);
+
+    atomic_init(&shared.done, false);
+
+    workers = malloc(nThreads * sizeof(*workers));
+    for (i = 0; i < nThreads; i++) {
+        workers[i].shared = &shared;
+        workers[i].p = puzzle_clone(p);
+        workers[i].opts = *opts;
+        if (opts->stats != NULL)
+            workers[i].opts.stats = &workers[i].stats;
+        if (i > 0)
+            workers[i].opts.trace = NULL;
+        workers[i].opts.checkpoint = NULL;
+        workers[i].opts.resume = NULL;
+        _portfolioConfig(i, &opts->config, &workers[i].opts.config);
+        workers[i].assignments = 0;
+        workers[i].decided = false;
+        pthread_create(&workers[i].thread, NULL, _portfolioWorker, &workers[i]);
+    }
+
+    for (i = 0; i < nThreads; i++) {
+        pthread_join(workers[i].thread, NULL);
+        if (workers[i].decided)
+            decider = &workers[i];
+        if (workers[i].assignments > maxAssignments)
+            maxAssignments = workers[i].assignments;
+
+        // Sem thread vencedora, prevalece o motivo mais externo de parada
+        if (workers[i].status == SOLVE_TIMEOUT && status != SOLVE_CANCELLED)
+            status = SOLVE_TIMEOUT;
+        if (workers[i].status == SOLVE_CANCELLED && opts->cancel != NULL
+                && atomic_load(opts->cancel))
+            status = SOLVE_CANCELLED;
+    }
+
+    // Publicar o resultado da thread vencedora
+    if (decider != NULL) {
+        if (decider->status == SOLVE_SOLVED)
+            puzzle_copyValues(p, decider->p);
+        if (opts->stats != NULL)
+            *opts->stats = decider->stats;
+        *assignments += decider->assignments;
+        status = decider->status;
+    } else {
+        *assignments += maxAssignments;
+    }
+
+    for (i = 0; i < nThreads; i++)
+        puzzle_destroy(workers[i].p);
+    free(workers);
+
+    return status;
+}
@@ -0,0 +1,119 @@
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "core/puzzle.h"
+#include "core/stats.h"
+
+// Atribui v a c e, como puzzle_simplify, preenche as células que ficarem
+// com um único valor possível até não restar nenhuma. Retorna se nenhuma
+// célula ficou sem valores e nenhuma desigualdade ficou impossível. Todas
+// as atribuições são desfeitas antes de retornar.
+bool _probe_try(Search *s, Cell *c, uchar v) {
+    Puzzle *p = s->p;
+    Cell **stack = s->probeStack;
+    size_t top = 0;
+    bool ok = true, altered;
+    uchar i, j;
+    Cell *d;
+
+    s->kernel->update(p, c, v);
+    c->val = v;
+    stack[top++] = c;
+
+    do {
+        altered = false;
+        for (i = 0; ok && i < p->size; i++) {
+            for (j = 0; ok && j < p->size; j++) {
+                d = p->cells[i][j];
+                if (d->val > 0 || d->nPossibilities > 1)
+                    continue;
+                if (d->nPossibilities == 0) {
+                    ok = false;
+                } else {
+                    v = cell_smallestPossibility(p, d);
+                    s->kernel->update(p, d, v);
+                    d->val = v;
+                    stack[top++] = d;
+                    altered = true;
+                }
+            }
+        }
+    } while (ok && altered);
+
+    if (ok)
+        ok = !_ineqViolated(p);
+
+    while (top > 0) {
+        d = stack[--top];
+        s->kernel->update(p, d, 0);
+        d->val = 0;
+    }
+    return ok;
+}
+
+// Descarta o valor v de c até que a busca volte acima do nó atual
+void _probe_remove(Search *s, Cell *c, uchar v) {
+    if (s->nRemoved == s->removedCap) {
+        s->removedCap = s->removedCap > 0 ? 2 * s->removedCap : 64;
+        s->removedCells = realloc(s->removedCells, s->removedCap * sizeof(*s->removedCells));
+        s->removedVals = realloc(s->removedVals, s->removedCap * sizeof(*s->removedVals));
+    }
+    s->removedCells[s->nRemoved] = c;
+    s->removedVals[s->nRemoved] = v;
+    s->nRemoved++;
+
+    if (c->restrictedValues[v-1]++ == 0)
+        c->nPossibilities--;
+}
+
+bool _probe(Search *s) {
+    Puzzle *p = s->p;
+    unsigned int budget = s->cfg->probeBudget;
+    bool altered;
+    uchar i, j, v;
+    Cell *c;
+
+    // Repetir enquanto algum valor for descartado, pois cada descarte pode
+    // fazer outras atribuições falharem
+    do {
+        altered = false;
+        for (i = 0; i < p->size; i++) {
+            for (j = 0; j < p->size; j++) {
+                c = p->cells[i][j];
+                if (c->val > 0)
+                    continue;
+                for (v = 1; v <= p->size; v++) {
+                    if (c->restrictedValues[v-1] > 0)
+                        continue;
+                    if (s->cfg->probeBudget > 0 && budget-- == 0)
+                        return true;
+
+                    STATS_INC(s, probes);
+                    if (_probe_try(s, c, v))
+                        continue;
+
+                    STATS_INC(s, probeRemovals);
+                    _probe_remove(s, c, v);
+                    altered = true;
+                    if (c->nPossibilities == 0)
+                        return false;
+                }
+            }
+        }
+    } while (altered);
+
+    return true;
+}
+
+void _probe_undo(Search *s, size_t mark) {
+    Cell *c;
+    uchar v;
+
+    while (s->nRemoved > mark) {
+        s->nRemoved--;
+        c = s->removedCells[s->nRemoved];
+        v = s->removedVals[s->nRemoved];
+        if (--c->restrictedValues[v-1] == 0)
+            c->nPossibilities++;
+    }
+}
@@ -0,0 +1,321 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "core/session.h"
+#include "core/futoshiki.h"
+#include "core/puzzle.h"
+
+struct Session {
+    uchar size;
+
+    // Dados iniciais e jogadas, linha a linha (0 para vazio)
+    uchar *givens;
+    uchar *entries;
+
+    // Tabuleiro com os dados iniciais e as jogadas, cujos contadores de
+    // restrições são mantidos a cada jogada
+    Puzzle *state;
+
+    // Células já preenchidas em state ao carregar: dados iniciais e
+    // valores deduzidos deles, que valem em toda solução
+    bool *fixed;
+
+    // Jogadas que contradizem algum valor deduzido
+    size_t against;
+
+    // Células vazias agrupadas pelo número de valores possíveis, em listas
+    // duplamente encadeadas pelos índices: head[k] é a primeira com k
+    // valores, next e prev as ligam e bucket[n] é a lista da célula n, -1
+    // se preenchida. NIL marca o fim de uma lista
+    size_t *head;
+    size_t *next;
+    size_t *prev;
+    int *bucket;
+
+    // Cópia de state usada pelas buscas
+    Puzzle *work;
+    SolveOptions opts;
+    const SearchKernel *kernel;
+    int64_t assignments;
+
+    // Última solução encontrada e número de jogadas que discordam dela
+    uchar *solution;
+    bool hasSolution;
+    size_t mismatches;
+
+    // Resposta de session_status, válida enquanto dirty for false
+    SolveStatus status;
+    bool dirty;
+};
+
+#define NIL(s) ((size_t) (s)->size * (s)->size)
+
+// Tira a célula de índice n de sua lista, se estiver em alguma
+void _session_unlink(Session *s, size_t n) {
+    if (s->bucket[n] < 0)
+        return;
+    if (s->prev[n] != NIL(s))
+        s->next[s->prev[n]] = s->next[n];
+    else
+        s->head[s->bucket[n]] = s->next[n];
+    if (s->next[n] != NIL(s))
+        s->prev[s->next[n]] = s->prev[n];
+    s->bucket[n] = -1;
+}
+
+// Põe a célula de índice n, se vazia, na lista de seu número de valores
+// possíveis. Valores deduzidos ao carregar contam como uma única
+// possibilidade
+void _session_link(Session *s, size_t n) {
+    int k;
+
+    if (s->givens[n] > 0 || s->entries[n] > 0)
+        return;
+    k = s->fixed[n] ? 1 : s->state->cells[n / s->size][n % s->size]->nPossibilities;
+    s->bucket[n] = k;
+    s->prev[n] = NIL(s);
+    s->next[n] = s->head[k];
+    if (s->head[k] != NIL(s))
+        s->prev[s->head[k]] = n;
+    s->head[k] = n;
+}
+
+// Atualiza as listas após uma jogada na célula de índice n, que só muda os
+// valores possíveis das células de sua linha e coluna
+void _session_relink(Session *s, size_t n) {
+    size_t row = n / s->size, col = n % s->size, k, m;
+
+    for (k = 0; k < s->size; k++) {
+        m = row * s->size + k;
+        _session_unlink(s, m);
+        _session_link(s, m);
+        if (k != row) {
+            m = k * s->size + col;
+            _session_unlink(s, m);
+            _session_link(s, m);
+        }
+    }
+}
+
+Session *session_new(uchar size, const uchar *grid, size_t nConstr, const PuzzleConstr *constr,
+        const SolveOptions *opts) {
+    size_t nCells = (size_t) size * size, n;
+    Puzzle *p = puzzle_fromGrid(size, grid, nConstr, constr);
+    Session *s;
+
+    if (p == NULL)
+        return NULL;
+
+    s = malloc(sizeof(*s));
+    s->size = size;
+    s->givens = malloc(nCells * sizeof(*s->givens));
+    memcpy(s->givens, grid, nCells * sizeof(*s->givens));
+    s->entries = calloc(nCells, sizeof(*s->entries));
+    s->state = p;
+    s->fixed = malloc(nCells * sizeof(*s->fixed));
+    for (n = 0; n < nCells; n++)
+        s->fixed[n] = p->cells[n / size][n % size]->val > 0;
+    s->against = 0;
+
+    s->head = malloc((size + 1) * sizeof(*s->head));
+    for (n = 0; n <= size; n++)
+        s->head[n] = nCells;
+    s->next = malloc(nCells * sizeof(*s->next));
+    s->prev = malloc(nCells * sizeof(*s->prev));
+    s->bucket = malloc(nCells * sizeof(*s->bucket));
+    for (n = nCells; n > 0; n--) {
+        s->bucket[n - 1] = -1;
+        _session_link(s, n - 1);
+    }
+
+    s->work = puzzle_clone(p);
+    s->opts = opts != NULL ? *opts : solveoptions_default();
+    s->opts.deadline = 0;
+    s->opts.config.symmetryBreaking = false;
+    s->kernel = searchkernel_get(size);
+    s->assignments = 0;
+
+    s->solution = malloc(nCells * sizeof(*s->solution));
+    s->hasSolution = false;
+    s->mismatches = 0;
+    s->dirty = true;
+
+    return s;
+}
+
+void session_destroy(Session *s) {
+    puzzle_destroy(s->state);
+    puzzle_destroy(s->work);
+    free(s->givens);
+    free(s->entries);
+    free(s->fixed);
+    free(s->head);
+    free(s->next);
+    free(s->prev);
+    free(s->bucket);
+    free(s->solution);
+    free(s);
+}
+
+// Registra a jogada val na célula de índice n, ainda vazia
+void _session_place(Session *s, size_t n, uchar val) {
+    Cell *c = s->state->cells[n / s->size][n % s->size];
+
+    s->entries[n] = val;
+    if (s->fixed[n]) {
+        if (c->val != val)
+            s->against++;
+    } else {
+        s->kernel->update(s->state, c, val);
+        c->val = val;
+    }
+    if (s->hasSolution && s->solution[n] != val)
+        s->mismatches++;
+    _session_relink(s, n);
+}
+
+// Desfaz a jogada da célula de índice n
+void _session_remove(Session *s, size_t n) {
+    Cell *c = s->state->cells[n / s->size][n % s->size];
+    uchar val = s->entries[n];
+
+    s->entries[n] = 0;
+    if (s->fixed[n]) {
+        if (c->val != val)
+            s->against--;
+    } else {
+        s->kernel->update(s->state, c, 0);
+        c->val = 0;
+    }
+    if (s->hasSolution && s->solution[n] != val)
+        s->mismatches--;
+    _session_relink(s, n);
+}
+
+bool session_set(Session *s, uchar row, uchar col, uchar val) {
+    size_t n = (size_t) row * s->size + col;
+    bool wasEmpty;
+
+    if (row >= s->size || col >= s->size || val == 0 || val > s->size || s->givens[n] > 0)
+        return false;
+    if (s->entries[n] == val)
+        return true;
+
+    wasEmpty = s->entries[n] == 0;
+    if (!wasEmpty)
+        _session_remove(s, n);
+    _session_place(s, n, val);
+
+    // Mais uma jogada não torna solúvel uma posição sem solução
+    if (!wasEmpty || s->dirty || s->status != SOLVE_UNSAT)
+        s->dirty = true;
+    return true;
+}
+
+bool session_clear(Session *s, uchar row, uchar col) {
+    size_t n = (size_t) row * s->size + col;
+
+    if (row >= s->size || col >= s->size || s->givens[n] > 0)
+        return false;
+    if (s->entries[n] > 0) {
+        _session_remove(s, n);
+        s->dirty = true;
+    }
+    return true;
+}
+
+uchar session_get(const Session *s, uchar row, uchar col) {
+    size_t n = (size_t) row * s->size + col;
+
+    if (row >= s->size || col >= s->size)
+        return 0;
+    return s->givens[n] > 0 ? s->givens[n] : s->entries[n];
+}
+
+// Retorna se alguma jogada repete um valor na linha ou coluna, usa um valor
+// descartado ao carregar o tabuleiro ou desrespeita uma desigualdade com
+// outra célula preenchida
+bool _session_conflict(Session *s) {
+    Puzzle *p = s->state;
+    size_t n, nCells = (size_t) s->size * s->size;
+    unsigned int k;
+    Cell *c;
+
+    for (n = 0; n < nCells; n++) {
+        c = p->cells[n / s->size][n % s->size];
+        if (s->entries[n] == 0 || s->fixed[n])
+            continue;
+        if (c->restrictedValues[c->val - 1] > 0)
+            return true;
+        for (k = 0; k < c->nGreater; k++)
+            if (c->greater[k]->val > 0 && c->greater[k]->val <= c->val)
+                return true;
+        for (k = 0; k < c->nSmaller; k++)
+            if (c->smaller[k]->val >= c->val)
+                return true;
+    }
+    return false;
+}
+
+SolveStatus session_status(Session *s) {
+    int64_t assignments;
+
+    if (!s->dirty)
+        return s->status;
+    s->dirty = false;
+
+    // A última solução ainda mantém todas as jogadas, que portanto não
+    // conflitam entre si nem com os valores deduzidos
+    if (s->hasSolution && s->mismatches == 0) {
+        s->status = SOLVE_SOLVED;
+        return s->status;
+    }
+
+    if (s->state->unsat || s->against > 0 || _session_conflict(s)) {
+        s->status = SOLVE_UNSAT;
+        return s->status;
+    }
+
+    // Cada busca tem o limite de atribuições inteiro, e não o que sobrou
+    // das anteriores
+    puzzle_copyValues(s->work, s->state);
+    assignments = 0;
+    s->status = _solve(s->work, &s->opts, NULL, &assignments);
+    s->assignments += assignments;
+    if (s->status == SOLVE_SOLVED) {
+        puzzle_getValues(s->work, s->solution);
+        s->hasSolution = true;
+        s->mismatches = 0;
+    }
+    return s->status;
+}
+
+bool session_hint(Session *s, uchar *row, uchar *col, uchar *val) {
+    size_t best = NIL(s);
+    unsigned int k;
+
+    if (session_status(s) != SOLVE_SOLVED)
+        return false;
+
+    for (k = 0; k <= s->size && best == NIL(s); k++)
+        best = s->head[k];
+    if (best == NIL(s))
+        return false;
+
+    *row = best / s->size;
+    *col = best % s->size;
+    *val = s->solution[best];
+    return true;
+}
+
+bool session_getSolution(Session *s, uchar *out) {
+    if (session_status(s) != SOLVE_SOLVED)
+        return false;
+    memcpy(out, s->solution, (size_t) s->size * s->size * sizeof(*out));
+    return true;
+}
+
+int64_t session_assignments(const Session *s) {
+    return s->assignments;
+}
@@ -0,0 +1,164 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+
+#include "core/snapshot.h"
+#include "core/puzzle.h"
+
+/*
+ * Formato: o tamanho do tabuleiro, os valores das células linha a linha e,
+ * para cada célula, um mapa de bits dos valores descartados além dos que
+ * as outras células de sua linha e coluna já impedem.
+ */
+
+struct SnapshotPool {
+    uchar size;
+    size_t bytes;
+
+    // Buffers devolvidos, encadeados pelo seu início
+    void *free;
+
+    // Tabela de _snapshot_lines, refeita a cada uso
+    uchar *lines;
+};
+
+/*
+ * Valores presentes em cada linha e coluna: has[line * size + v - 1] é 1 se
+ * v está na linha (0 a size - 1) ou coluna (size a 2 size - 1). Mantidos em
+ * bytes, e não em bits, para que o laço de cada valor seja só de somas.
+ */
+uchar *_snapshot_lines(SnapshotPool *pool, const uchar *vals) {
+    size_t n = pool->size, i, j;
+    uchar *has = pool->lines;
+    uchar v;
+
+    memset(has, 0, 2 * n * n);
+    for (i = 0; i < n; i++) {
+        for (j = 0; j < n; j++) {
+            v = vals[i * n + j];
+            if (v > 0) {
+                has[i * n + v - 1] = 1;
+                has[(n + j) * n + v - 1] = 1;
+            }
+        }
+    }
+    return has;
+}
+
+size_t _snapshot_maskBytes(uchar size) {
+    return (size + 7) / 8;
+}
+
+size_t snapshot_size(uchar size) {
+    return 1 + (size_t) size * size * (1 + _snapshot_maskBytes(size));
+}
+
+void puzzle_saveSnapshot(const Puzzle *p, void *buf, SnapshotPool *pool) {
+    size_t n = p->size, maskBytes = _snapshot_maskBytes(p->size), i, j, v;
+    uchar *vals = (uchar *) buf + 1;
+    uchar *m = vals + n * n;
+    const uchar *row, *col, *restr;
+    uchar *has, bits;
+    size_t b, k;
+    Cell *c;
+
+    *(uchar *) buf = p->size;
+    for (i = 0; i < n; i++)
+        for (j = 0; j < n; j++)
+            vals[i * n + j] = p->cells[i][j]->val;
+    has = _snapshot_lines(pool, vals);
+
+    // O descartado além do que as outras células da linha e da coluna
+    // impedem, contadas como em _strengthenRestrValues
+    for (i = 0; i < n; i++) {
+        row = has + i * n;
+        for (j = 0; j < n; j++, m += maskBytes) {
+            c = p->cells[i][j];
+            col = has + (n + j) * n;
+            restr = c->restrictedValues;
+            for (b = 0, v = 0; b < maskBytes; b++) {
+                bits = 0;
+                for (k = 0; k < 8 && v < n; k++, v++)
+                    bits |= (restr[v] > row[v] + col[v]) << k;
+                m[b] = bits;
+            }
+
+            // O valor da própria célula conta na sua linha e coluna, mas
+            // não para ela
+            if (c->val > 0) {
+                v = c->val - 1;
+                m[v / 8] &= ~(1 << (v % 8));
+                m[v / 8] |= (restr[v] > row[v] + col[v] - 2) << (v % 8);
+            }
+        }
+    }
+}
+
+void puzzle_restoreSnapshot(Puzzle *p, const void *buf, SnapshotPool *pool) {
+    size_t n = p->size, maskBytes = _snapshot_maskBytes(p->size), i, j, v;
+    const uchar *vals = (const uchar *) buf + 1;
+    const uchar *m = vals + n * n;
+    const uchar *row, *col;
+    uchar *has, *restr, possible;
+    Cell *c;
+
+    has = _snapshot_lines(pool, vals);
+    for (i = 0; i < n; i++) {
+        row = has + i * n;
+        for (j = 0; j < n; j++, m += maskBytes) {
+            c = p->cells[i][j];
+            col = has + (n + j) * n;
+            restr = c->restrictedValues;
+            c->val = vals[i * n + j];
+            c->orderPos = 0;
+            for (v = 0; v < n; v++)
+                restr[v] = row[v] + col[v] + ((m[v / 8] >> (v % 8)) & 1);
+            if (c->val > 0)
+                restr[c->val - 1] -= 2;
+
+            possible = 0;
+            for (v = 0; v < n; v++)
+                possible += restr[v] == 0;
+            c->nPossibilities = possible;
+        }
+    }
+}
+
+SnapshotPool *snapshotpool_new(uchar size) {
+    SnapshotPool *pool = malloc(sizeof(*pool));
+
+    // Cada buffer livre guarda o ponteiro para o próximo
+    pool->size = size;
+    pool->bytes = snapshot_size(size);
+    if (pool->bytes < sizeof(void *))
+        pool->bytes = sizeof(void *);
+    pool->free = NULL;
+    pool->lines = malloc(2 * (size_t) size * size);
+    return pool;
+}
+
+void snapshotpool_destroy(SnapshotPool *pool) {
+    void *buf, *next;
+
+    for (buf = pool->free; buf != NULL; buf = next) {
+        memcpy(&next, buf, sizeof(next));
+        free(buf);
+    }
+    free(pool->lines);
+    free(pool);
+}
+
+void *snapshotpool_get(SnapshotPool *pool) {
+    void *buf = pool->free;
+
+    if (buf == NULL)
+        return malloc(pool->bytes);
+    memcpy(&pool->free, buf, sizeof(pool->free));
+    return buf;
+}
+
+void snapshotpool_put(SnapshotPool *pool, void *buf) {
+    memcpy(buf, &pool->free, sizeof(pool->free));
+    pool->free = buf;
+}
@@ -0,0 +1,221 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "core/futoshiki.h"
+#include "core/puzzle.h"
+#include "core/snapshot.h"
+
+// Nós na fila por thread abaixo dos quais uma thread divide o nó que pegou
+// em vez de explorá-lo
+#define SPLIT_NODES 4
+
+typedef struct Split Split;
+
+typedef struct SplitWorker {
+    Split *shared;
+
+    // Tabuleiro desta thread, onde cada nó pego da fila é restaurado
+    Puzzle *p;
+    SnapshotPool *pool;
+    SolveOptions opts;
+
+    // Filhos do nó sendo dividido, antes de irem para a fila
+    void **children;
+
+    int64_t assignments;
+    pthread_t thread;
+} SplitWorker;
+
+struct Split {
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    int nThreads;
+
+    // Nós ainda não explorados, em pilha para seguir a ordem da busca
+    void **queue;
+    size_t nQueued;
+    size_t cap;
+
+    // Threads com um nó em mãos
+    int busy;
+
+    // Setada pela thread que achar uma solução ou tiver a busca interrompida
+    atomic_bool done;
+    SolveStatus status;
+    void *solution;
+};
+
+void _split_push(Split *sh, void **nodes, size_t n) {
+    pthread_mutex_lock(&sh->lock);
+    if (sh->nQueued + n > sh->cap) {
+        sh->cap = 2 * (sh->nQueued + n);
+        sh->queue = realloc(sh->queue, sh->cap * sizeof(*sh->queue));
+    }
+    // Em ordem inversa, para que o primeiro filho saia primeiro
+    while (n > 0)
+        sh->queue[sh->nQueued++] = nodes[--n];
+    pthread_cond_broadcast(&sh->ready);
+    pthread_mutex_unlock(&sh->lock);
+}
+
+// Encerra a busca com o resultado da thread, se nenhuma outra o fez antes
+void _split_decide(SplitWorker *w, SolveStatus status) {
+    Split *sh = w->shared;
+
+    pthread_mutex_lock(&sh->lock);
+    if (!atomic_exchange(&sh->done, true)) {
+        sh->status = status;
+        if (status == SOLVE_SOLVED) {
+            sh->solution = snapshotpool_get(w->pool);
+            puzzle_saveSnapshot(w->p, sh->solution, w->pool);
+        }
+    }
+    pthread_cond_broadcast(&sh->ready);
+    pthread_mutex_unlock(&sh->lock);
+}
+
+// Põe na fila os filhos do nó restaurado em w->p que passam pela
+// sondagem, pela propagação e pela quebra de simetria
+void _split_expand(SplitWorker *w) {
+    Search s;
+    Cell *c;
+    size_t n = 0;
+
+    _search_init(&s, w->p, &w->opts, &w->shared->done, &w->assignments);
+    c = cell_nextInSeq(&s, NULL);
+    if (c == NULL) {
+        if (puzzle_checkSolved(w->p))
+            _split_decide(w, SOLVE_SOLVED);
+    } else if (s.cfg->probeDepth == 0 || _probe(&s)) {
+        // Os valores descartados pela sondagem seguem nos filhos
+        while (cell_nextValue(&s, c)) {
+            if (s.cfg->symmetryBreaking && !symmetry_allowed(w->p, &w->p->sym))
+                continue;
+            w->children[n] = snapshotpool_get(w->pool);
+            puzzle_saveSnapshot(w->p, w->children[n++], w->pool);
+        }
+        if (n > 0)
+            _split_push(w->shared, w->children, n);
+    }
+    _probe_undo(&s, 0);
+    _search_free(&s);
+}
+
+void _split_solve(SplitWorker *w) {
+    SolveStatus status = _solve(w->p, &w->opts, &w->shared->done, &w->assignments);
+
+    // Uma subárvore sem solução não decide nada, e uma busca cancelada por
+    // outra thread já tem quem decida
+    if (status == SOLVE_UNSAT || atomic_load(&w->shared->done))
+        return;
+    _split_decide(w, status);
+}
+
+void *_split_worker(void *arg) {
+    SplitWorker *w = arg;
+    Split *sh = w->shared;
+    void *node;
+    bool expand;
+
+    for (;;) {
+        pthread_mutex_lock(&sh->lock);
+        while (sh->nQueued == 0 && sh->busy > 0 && !atomic_load(&sh->done))
+            pthread_cond_wait(&sh->ready, &sh->lock);
+        if (sh->nQueued == 0 || atomic_load(&sh->done)) {
+            pthread_mutex_unlock(&sh->lock);
+            break;
+        }
+        node = sh->queue[--sh->nQueued];
+        expand = sh->nQueued < (size_t) sh->nThreads * SPLIT_NODES;
+        sh->busy++;
+        pthread_mutex_unlock(&sh->lock);
+
+        // O buffer pode ter vindo de outra thread e fica com esta
+        puzzle_restoreSnapshot(w->p, node, w->pool);
+        snapshotpool_put(w->pool, node);
+        if (expand)
+            _split_expand(w);
+        else
+            _split_solve(w);
+
+        pthread_mutex_lock(&sh->lock);
+        sh->busy--;
+        pthread_cond_broadcast(&sh->ready);
+        pthread_mutex_unlock(&sh->lock);
+    }
+
+    return NULL;
+}
+
+SolveStatus puzzle_solveSplit(Puzzle *p, const SolveOptions *opts, int nThreads, int64_t *assignments) {
+    Split shared;
+    SolveOptions defaults;
+    SplitWorker *workers;
+    void *root;
+    int i;
+
+    if (opts == NULL) {
+        defaults = solveoptions_default();
+        opts = &defaults;
+    }
+    if (nThreads <= 1 || p->unsat)
+        return puzzle_solve(p, opts, assignments);
+
+    pthread_mutex_init(&shared.lock, NULL);
+    pthread_cond_init(&shared.ready, NULL);
+    shared.nThreads = nThreads;
+    shared.queue = NULL;
+    shared.nQueued = 0;
+    shared.cap = 0;
+    shared.busy = 0;
+    atomic_init(&shared.done, false);
+    shared.status = SOLVE_UNSAT;
+    shared.solution = NULL;
+
+    workers = malloc(nThreads * sizeof(*workers));
+    for (i = 0; i < nThreads; i++) {
+        workers[i].shared = &shared;
+        workers[i].p = puzzle_clone(p);
+        workers[i].pool = snapshotpool_new(p->size);
+        workers[i].opts = *opts;
+        workers[i].opts.stats = NULL;
+        workers[i].opts.trace = NULL;
+        workers[i].opts.checkpoint = NULL;
+        workers[i].opts.resume = NULL;
+        workers[i].children = malloc(p->size * sizeof(*workers[i].children));
+        workers[i].assignments = 0;
+    }
+
+    root = snapshotpool_get(workers[0].pool);
+    puzzle_saveSnapshot(p, root, workers[0].pool);
+    _split_push(&shared, &root, 1);
+
+    for (i = 0; i < nThreads; i++)
+        pthread_create(&workers[i].thread, NULL, _split_worker, &workers[i]);
+    for (i = 0; i < nThreads; i++) {
+        pthread_join(workers[i].thread, NULL);
+        *assignments += workers[i].assignments;
+    }
+
+    if (shared.solution != NULL) {
+        puzzle_restoreSnapshot(p, shared.solution, workers[0].pool);
+        snapshotpool_put(workers[0].pool, shared.solution);
+    }
+    // Nós que ficaram na fila quando a busca foi decidida
+    while (shared.nQueued > 0)
+        snapshotpool_put(workers[0].pool, shared.queue[--shared.nQueued]);
+
+    for (i = 0; i < nThreads; i++) {
+        puzzle_destroy(workers[i].p);
+        snapshotpool_destroy(workers[i].pool);
+        free(workers[i].children);
+    }
+    free(workers);
+    free(shared.queue);
+    pthread_mutex_destroy(&shared.lock);
+    pthread_cond_destroy(&shared.ready);
+
+    return shared.status;
+}
@@ -0,0 +1,58 @@
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "core/stats.h"
+
+static const char *phaseNames[PHASE_COUNT] = {
+    "forward_check",
+    "ineq_check",
+    "select",
+    "leaf_check"
+};
+
+void solvestats_clear(SolveStats *st) {
+    memset(st, 0, sizeof(*st));
+}
+
+void solvestats_printJson(const SolveStats *st, FILE *stream) {
+    unsigned int d, last;
+    int i;
+
+    fprintf(stream, "{\"nodes\":%" PRIu64 ",\"backtracks\":%" PRIu64
+            ",\"max_depth\":%u", st->nodes, st->backtracks, st->maxDepth);
+
+    fprintf(stream, ",\"propagation\":{\"forward_checks\":%" PRIu64
+            ",\"ineq_checks\":%" PRIu64 ",\"leaf_checks\":%" PRIu64 ",\"probes\":%" PRIu64
+            ",\"probe_removals\":%" PRIu64 "}",
+            st->forwardChecks, st->ineqChecks, st->leafChecks, st->probes, st->probeRemovals);
+
+    fprintf(stream, ",\"wipeouts\":{\"row_col\":%" PRIu64 ",\"ineq\":%" PRIu64
+            ",\"leaf\":%" PRIu64 ",\"symmetry\":%" PRIu64
+            ",\"transposition\":%" PRIu64 "}",
+            st->rowColWipeouts, st->ineqWipeouts, st->leafFailures, st->symmetryPrunes,
+            st->transpositionHits);
+
+    // Histograma até a última profundidade visitada
+    last = st->maxDepth < STATS_MAX_DEPTH ? st->maxDepth : STATS_MAX_DEPTH - 1;
+    fputs(",\"branching\":[", stream);
+    for (d = 0; d <= last && st->nodes > 0; d++) {
+        fprintf(stream, "%s{\"depth\":%u,\"nodes\":%" PRIu64 ",\"children\":%" PRIu64 "}",
+                d > 0 ? "," : "", d, st->depthNodes[d], st->depthChildren[d]);
+    }
+    fputc(']', stream);
+
+#ifdef FUTOSHIKI_TIMERS
+    fputs(",\"phase_time\":{", stream);
+    for (i = 0; i < PHASE_COUNT; i++) {
+        fprintf(stream, "%s\"%s\":%" PRIu64, i > 0 ? "," : "",
+                phaseNames[i], st->phaseTime[i]);
+    }
+    fputc('}', stream);
+#else
+    (void) i;
+    (void) phaseNames;
+#endif
+
+    fputs("}\n", stream);
+}
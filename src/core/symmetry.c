@@ -0,0 +1,296 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "core/symmetry.h"
+#include "core/puzzle.h"
+
+void symmetry_mapCell(int t, uchar size, uchar row, uchar col, uchar *outRow, uchar *outCol) {
+    uchar last = size - 1;
+
+    switch (t % SYMMETRY_DIHEDRAL) {
+        case 0: // Identidade
+            *outRow = row;
+            *outCol = col;
+            break;
+        case 1: // Rotação de 90 graus
+            *outRow = col;
+            *outCol = last - row;
+            break;
+        case 2: // Rotação de 180 graus
+            *outRow = last - row;
+            *outCol = last - col;
+            break;
+        case 3: // Rotação de 270 graus
+            *outRow = last - col;
+            *outCol = row;
+            break;
+        case 4: // Transposição
+            *outRow = col;
+            *outCol = row;
+            break;
+        case 5: // Reflexão horizontal
+            *outRow = row;
+            *outCol = last - col;
+            break;
+        case 6: // Reflexão vertical
+            *outRow = last - row;
+            *outCol = col;
+            break;
+        default: // Transposição pela diagonal secundária
+            *outRow = last - col;
+            *outCol = last - row;
+            break;
+    }
+}
+
+uchar symmetry_mapValue(int t, uchar size, uchar v) {
+    if (t < SYMMETRY_DIHEDRAL || v == 0)
+        return v;
+    return size + 1 - v;
+}
+
+size_t symmetry_keyLength(const Puzzle *p) {
+    // Tamanho, valores e 4 bytes por limitação
+    return 1 + (size_t) p->size * p->size + 4 * p->nConstr;
+}
+
+int _compareConstr(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+    return (x > y) - (x < y);
+}
+
+void symmetry_encode(const Puzzle *p, int t, uchar *out) {
+    size_t nConstr = p->nConstr;
+    uint32_t *constr = malloc((nConstr + 1) * sizeof(*constr));
+    uint32_t lo, hi;
+    uchar r, c, i, j;
+    unsigned int k;
+    size_t n = 0;
+    Cell *cell;
+
+    out[0] = p->size;
+    out++;
+
+    for (i = 0; i < p->size; i++) {
+        for (j = 0; j < p->size; j++) {
+            symmetry_mapCell(t, p->size, i, j, &r, &c);
+            out[r * p->size + c] = symmetry_mapValue(t, p->size, p->cells[i][j]->val);
+        }
+    }
+    out += p->size * p->size;
+
+    // Cada limitação vira o par (menor, maior) de índices transformados; a
+    // troca de valores inverte o sentido da desigualdade
+    for (i = 0; i < p->size; i++) {
+        for (j = 0; j < p->size; j++) {
+            cell = p->cells[i][j];
+            symmetry_mapCell(t, p->size, i, j, &r, &c);
+            lo = r * p->size + c;
+            for (k = 0; k < cell->nGreater; k++) {
+                symmetry_mapCell(t, p->size, cell->greater[k]->row, cell->greater[k]->col, &r, &c);
+                hi = r * p->size + c;
+                constr[n++] = t < SYMMETRY_DIHEDRAL ? lo << 16 | hi : hi << 16 | lo;
+            }
+        }
+    }
+
+    // Ordenadas, as limitações independem da ordem de leitura
+    qsort(constr, nConstr, sizeof(*constr), _compareConstr);
+    for (n = 0; n < nConstr; n++) {
+        out[4 * n] = constr[n] >> 24;
+        out[4 * n + 1] = constr[n] >> 16;
+        out[4 * n + 2] = constr[n] >> 8;
+        out[4 * n + 3] = constr[n];
+    }
+
+    free(constr);
+}
+
+int symmetry_canonical(const Puzzle *p, uchar *out) {
+    size_t len = symmetry_keyLength(p);
+    uchar *candidate = malloc(len);
+    int t, best = 0;
+
+    symmetry_encode(p, 0, out);
+    for (t = 1; t < SYMMETRY_COUNT; t++) {
+        symmetry_encode(p, t, candidate);
+        if (memcmp(candidate, out, len) < 0) {
+            memcpy(out, candidate, len);
+            best = t;
+        }
+    }
+
+    free(candidate);
+    return best;
+}
+
+// Transformação inversa: apenas as rotações de 90 e 270 graus não são suas
+// próprias inversas
+int _symmetry_inverse(int t) {
+    switch (t % SYMMETRY_DIHEDRAL) {
+        case 1:
+            return t + 2;
+        case 3:
+            return t - 2;
+        default:
+            return t;
+    }
+}
+
+void symmetry_detect(const Puzzle *p, SymmetryGroup *g) {
+    size_t len = symmetry_keyLength(p);
+    uchar *identity = malloc(len);
+    uchar *candidate = malloc(len);
+    bool present[UCHAR_MAX + 1] = { false };
+    uchar i, j;
+    int t;
+
+    g->nAuto = 0;
+    symmetry_encode(p, 0, identity);
+    for (t = 1; t < SYMMETRY_COUNT; t++) {
+        symmetry_encode(p, t, candidate);
+        if (memcmp(candidate, identity, len) == 0)
+            g->autos[g->nAuto++] = t;
+    }
+
+    // Sem desigualdades, os valores ausentes da grade são intercambiáveis
+    g->nInterch = 0;
+    if (p->nConstr == 0) {
+        for (i = 0; i < p->size; i++)
+            for (j = 0; j < p->size; j++)
+                present[p->cells[i][j]->val] = true;
+        for (i = 1; i <= p->size; i++)
+            if (!present[i])
+                g->interch[g->nInterch++] = i;
+    }
+    // Trocar apenas dois valores não é simetria alguma a quebrar se só um
+    if (g->nInterch < 2)
+        g->nInterch = 0;
+
+    free(candidate);
+    free(identity);
+}
+
+// Compara a grade com sua imagem pela transformação t, célula a célula em
+// ordem de linhas, até a primeira posição indefinida. Retorna -1, 0 ou 1 se
+// a grade é menor, ainda indistinguível ou maior que a imagem.
+int _symmetry_compare(const Puzzle *p, int t) {
+    int inv = _symmetry_inverse(t);
+    uchar i, j, r, c, x, y;
+
+    for (i = 0; i < p->size; i++) {
+        for (j = 0; j < p->size; j++) {
+            // Valor da imagem em (i, j) vem da célula que t leva até ela
+            symmetry_mapCell(inv, p->size, i, j, &r, &c);
+            x = p->cells[i][j]->val;
+            y = symmetry_mapValue(t, p->size, p->cells[r][c]->val);
+            if (x == 0 || y == 0)
+                return 0;
+            if (x != y)
+                return x < y ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+bool symmetry_allowed(const Puzzle *p, const SymmetryGroup *g) {
+    uchar rank[UCHAR_MAX + 1] = { 0 };
+    uchar i, j, v, seen = 0;
+    int k;
+
+    for (k = 0; k < g->nAuto; k++)
+        if (_symmetry_compare(p, g->autos[k]) > 0)
+            return false;
+
+    // Valores intercambiáveis devem aparecer pela primeira vez em ordem
+    // crescente; rank é a posição de cada um em interch, a partir de 1
+    if (g->nInterch > 0) {
+        for (k = 0; k < g->nInterch; k++)
+            rank[g->interch[k]] = k + 1;
+        for (i = 0; i < p->size; i++) {
+            for (j = 0; j < p->size; j++) {
+                v = p->cells[i][j]->val;
+                if (v == 0)
+                    return true;
+                if (rank[v] > seen + 1)
+                    return false;
+                if (rank[v] == seen + 1)
+                    seen++;
+            }
+        }
+    }
+    return true;
+}
+
+// Escreve em out a imagem da grade pela transformação t, com os valores
+// intercambiáveis renomeados pela ordem de primeira aparição: a menor grade
+// entre as que diferem apenas por esses valores
+void _symmetry_image(const Puzzle *p, const SymmetryGroup *g, int t, uchar *out) {
+    uchar rename[UCHAR_MAX + 1] = { 0 };
+    bool interch[UCHAR_MAX + 1] = { false };
+    uchar i, j, r, c, next = 0;
+    size_t k, n = (size_t) p->size * p->size;
+
+    for (i = 0; i < p->size; i++) {
+        for (j = 0; j < p->size; j++) {
+            symmetry_mapCell(t, p->size, i, j, &r, &c);
+            out[r * p->size + c] = symmetry_mapValue(t, p->size, p->cells[i][j]->val);
+        }
+    }
+
+    for (i = 0; i < g->nInterch; i++)
+        interch[g->interch[i]] = true;
+    for (k = 0; k < n && g->nInterch > 0; k++) {
+        if (!interch[out[k]])
+            continue;
+        if (rename[out[k]] == 0)
+            rename[out[k]] = g->interch[next++];
+        out[k] = rename[out[k]];
+    }
+}
+
+uint64_t symmetry_orbit(const Puzzle *p, const SymmetryGroup *g) {
+    size_t n = (size_t) p->size * p->size;
+    uchar *images = malloc((g->nAuto + 1) * n);
+    uint64_t orbit = 0, perms = 1;
+    int k, l;
+    bool repeated;
+
+    // A grade deve ser a menor de sua órbita
+    _symmetry_image(p, g, 0, images);
+    for (l = 0; l < (int) n; l++) {
+        if (images[l] != p->cells[l / p->size][l % p->size]->val) {
+            free(images);
+            return 0;
+        }
+    }
+    for (k = 1; k <= g->nAuto; k++) {
+        _symmetry_image(p, g, g->autos[k - 1], images + k * n);
+        if (memcmp(images + k * n, images, n) < 0) {
+            free(images);
+            return 0;
+        }
+    }
+
+    // Cada imagem distinta representa nInterch! grades distintas, já que
+    // permutar valores de uma grade completa sempre a altera
+    for (k = 0; k <= g->nAuto; k++) {
+        repeated = false;
+        for (l = 0; l < k && !repeated; l++)
+            repeated = memcmp(images + k * n, images + l * n, n) == 0;
+        if (!repeated)
+            orbit++;
+    }
+    for (k = 2; k <= g->nInterch; k++) {
+        if (perms > UINT64_MAX / k) {
+            free(images);
+            return UINT64_MAX;
+        }
+        perms *= k;
+    }
+
+    free(images);
+    return orbit > UINT64_MAX / perms ? UINT64_MAX : orbit * perms;
+}
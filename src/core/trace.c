@@ -0,0 +1,258 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "core/trace.h"
+#include "core/futoshiki.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define _trace_clock() __rdtsc()
+#else
+#define _trace_clock() futoshiki_now()
+#endif
+
+struct Trace {
+    TraceEvent *events;
+    size_t mask;
+
+    // Número total de eventos registrados desde o último trace_clear
+    uint64_t head;
+
+    // Referência para converter o relógio dos eventos em microssegundos
+    uint64_t startTicks;
+    uint64_t startNs;
+};
+
+Trace *trace_new(size_t capacity) {
+    Trace *t = malloc(sizeof(*t));
+    size_t size = 1;
+
+    while (size < capacity)
+        size <<= 1;
+
+    t->events = malloc(size * sizeof(*t->events));
+    t->mask = size - 1;
+    trace_clear(t);
+
+    return t;
+}
+
+void trace_destroy(Trace *t) {
+    free(t->events);
+    free(t);
+}
+
+void trace_clear(Trace *t) {
+    t->head = 0;
+    t->startNs = futoshiki_now();
+    t->startTicks = _trace_clock();
+}
+
+void trace_record(Trace *t, TraceEventType type, unsigned int depth, uint8_t row, uint8_t col, uint8_t val) {
+    TraceEvent *e = &t->events[t->head & t->mask];
+
+    e->time = _trace_clock();
+    e->depth = depth;
+    e->type = type;
+    e->row = row;
+    e->col = col;
+    e->val = val;
+    t->head++;
+}
+
+size_t trace_length(const Trace *t) {
+    return t->head > t->mask ? t->mask + 1 : t->head;
+}
+
+uint64_t trace_dropped(const Trace *t) {
+    return t->head - trace_length(t);
+}
+
+const TraceEvent *trace_get(const Trace *t, size_t i) {
+    return &t->events[(trace_dropped(t) + i) & t->mask];
+}
+
+// Ticks do relógio dos eventos por microssegundo
+double _trace_ticksPerUs(const Trace *t) {
+    uint64_t ns = futoshiki_now() - t->startNs;
+    uint64_t ticks = _trace_clock() - t->startTicks;
+
+    if (ns == 0 || ticks == 0)
+        return 1000.0;
+    return ticks * 1000.0 / ns;
+}
+
+unsigned int _trace_maxDepth(const Trace *t) {
+    size_t i, n = trace_length(t);
+    unsigned int max = 0;
+
+    for (i = 0; i < n; i++)
+        if (trace_get(t, i)->depth > max)
+            max = trace_get(t, i)->depth;
+    return max;
+}
+
+void _chrome_end(FILE *stream, int pid, double ts) {
+    fprintf(stream, ",\n{\"ph\":\"E\",\"pid\":%d,\"tid\":0,\"ts\":%.3f}", pid, ts);
+}
+
+// Fecha os intervalos abertos em profundidade maior ou igual a depth
+void _chrome_closeFrom(FILE *stream, int pid, double ts, bool *open, unsigned int *top, unsigned int depth) {
+    while (*top > depth) {
+        (*top)--;
+        if (open[*top]) {
+            open[*top] = false;
+            _chrome_end(stream, pid, ts);
+        }
+    }
+}
+
+void trace_exportChrome(const Trace *t, FILE *stream, int pid) {
+    size_t i, n = trace_length(t);
+    unsigned int maxDepth = _trace_maxDepth(t);
+    bool *open = calloc(maxDepth + 1, sizeof(*open));
+    unsigned int top = 0;
+    double perUs = _trace_ticksPerUs(t);
+    double ts = 0;
+    const TraceEvent *e;
+
+    fprintf(stream, ",\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+            "\"args\":{\"name\":\"busca %d\"}}", pid, pid);
+
+    for (i = 0; i < n; i++) {
+        e = trace_get(t, i);
+        ts = (double) (int64_t) (e->time - t->startTicks) / perUs;
+
+        switch (e->type) {
+            case TRACE_DECIDE:
+                _chrome_closeFrom(stream, pid, ts, open, &top, e->depth);
+                fprintf(stream, ",\n{\"name\":\"r%uc%u=%u\",\"ph\":\"B\",\"pid\":%d,"
+                        "\"tid\":0,\"ts\":%.3f,\"args\":{\"depth\":%u}}",
+                        e->row + 1, e->col + 1, e->val, pid, ts, e->depth);
+                open[e->depth] = true;
+                top = e->depth + 1;
+                break;
+            case TRACE_WIPEOUT:
+            case TRACE_BACKTRACK:
+                _chrome_closeFrom(stream, pid, ts, open, &top, e->depth);
+                break;
+            case TRACE_SOLUTION:
+            case TRACE_LEAF_FAIL:
+                fprintf(stream, ",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":%d,"
+                        "\"tid\":0,\"ts\":%.3f}",
+                        e->type == TRACE_SOLUTION ? "solucao" : "folha invalida", pid, ts);
+                break;
+            default:
+                break;
+        }
+    }
+    _chrome_closeFrom(stream, pid, ts, open, &top, 0);
+
+    free(open);
+}
+
+/*
+ * Árvore de prefixos dos caminhos de decisão, usada para agregar as pilhas
+ * do formato folded. Cada nó é uma célula decidida abaixo do nó pai.
+ */
+typedef struct FoldNode {
+    uint8_t row;
+    uint8_t col;
+    size_t firstChild;
+    size_t nextSibling;
+    uint64_t count;
+} FoldNode;
+
+#define FOLD_NONE ((size_t) -1)
+
+typedef struct FoldTree {
+    FoldNode *nodes;
+    size_t length;
+    size_t capacity;
+} FoldTree;
+
+size_t _fold_child(FoldTree *tree, size_t parent, uint8_t row, uint8_t col) {
+    size_t i = tree->nodes[parent].firstChild;
+    FoldNode *n;
+
+    while (i != FOLD_NONE) {
+        if (tree->nodes[i].row == row && tree->nodes[i].col == col)
+            return i;
+        i = tree->nodes[i].nextSibling;
+    }
+
+    if (tree->length == tree->capacity) {
+        tree->capacity *= 2;
+        tree->nodes = realloc(tree->nodes, tree->capacity * sizeof(*tree->nodes));
+    }
+
+    i = tree->length++;
+    n = &tree->nodes[i];
+    n->row = row;
+    n->col = col;
+    n->firstChild = FOLD_NONE;
+    n->count = 0;
+    n->nextSibling = tree->nodes[parent].firstChild;
+    tree->nodes[parent].firstChild = i;
+
+    return i;
+}
+
+void _fold_print(const FoldTree *tree, size_t node, char *path, size_t len, FILE *stream) {
+    const FoldNode *n = &tree->nodes[node];
+    size_t child;
+    int written;
+
+    if (node != 0) {
+        written = sprintf(path + len, ";r%uc%u", n->row + 1, n->col + 1);
+        len += written;
+    }
+    if (n->count > 0)
+        fprintf(stream, "%.*s %" PRIu64 "\n", (int) len, path, n->count);
+
+    for (child = n->firstChild; child != FOLD_NONE; child = tree->nodes[child].nextSibling)
+        _fold_print(tree, child, path, len, stream);
+}
+
+void trace_exportFolded(const Trace *t, FILE *stream, const char *root) {
+    size_t i, n = trace_length(t);
+    unsigned int maxDepth = _trace_maxDepth(t);
+    // path[d] é o nó da decisão atual na profundidade d; known é o número
+    // de níveis conhecidos (eventos anteriores podem ter sido sobrescritos)
+    size_t *path = malloc((maxDepth + 1) * sizeof(*path));
+    unsigned int known = 0;
+    size_t parent;
+    char *label;
+    FoldTree tree;
+    const TraceEvent *e;
+
+    tree.capacity = 64;
+    tree.length = 1;
+    tree.nodes = malloc(tree.capacity * sizeof(*tree.nodes));
+    tree.nodes[0].firstChild = FOLD_NONE;
+    tree.nodes[0].nextSibling = FOLD_NONE;
+    tree.nodes[0].count = 0;
+
+    for (i = 0; i < n; i++) {
+        e = trace_get(t, i);
+        if (e->type != TRACE_DECIDE)
+            continue;
+
+        parent = e->depth > 0 && e->depth <= known ? path[e->depth - 1] : 0;
+        path[e->depth] = _fold_child(&tree, parent, e->row, e->col);
+        tree.nodes[path[e->depth]].count++;
+        known = e->depth + 1;
+    }
+
+    // Cada quadro ocupa no máximo ";r255c255"
+    label = malloc(strlen(root) + (maxDepth + 1) * 10 + 1);
+    strcpy(label, root);
+    _fold_print(&tree, 0, label, strlen(root), stream);
+
+    free(label);
+    free(tree.nodes);
+    free(path);
+}
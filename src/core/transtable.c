@@ -0,0 +1,96 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#include "core/transtable.h"
+
+// Entradas por balde
+#define WAYS 4
+
+// Marca de entrada vazia; o hash 0 é guardado como 1
+#define EMPTY 0
+
+struct TransTable {
+    _Atomic uint64_t *slots;
+
+    // Número de baldes menos 1
+    size_t mask;
+};
+
+TransTable *transtable_new(size_t capacity) {
+    TransTable *t = malloc(sizeof(*t));
+    size_t nBuckets = 1;
+
+    while (nBuckets * WAYS < capacity)
+        nBuckets <<= 1;
+
+    t->slots = malloc(nBuckets * WAYS * sizeof(*t->slots));
+    t->mask = nBuckets - 1;
+    transtable_clear(t);
+
+    return t;
+}
+
+void transtable_destroy(TransTable *t) {
+    free(t->slots);
+    free(t);
+}
+
+void transtable_clear(TransTable *t) {
+    size_t i;
+
+    for (i = 0; i < (t->mask + 1) * WAYS; i++)
+        atomic_init(&t->slots[i], EMPTY);
+}
+
+bool transtable_contains(const TransTable *t, uint64_t hash) {
+    _Atomic uint64_t *bucket = &t->slots[(hash & t->mask) * WAYS];
+    int i;
+
+    if (hash == EMPTY)
+        hash = 1;
+    for (i = 0; i < WAYS; i++)
+        if (atomic_load_explicit(&bucket[i], memory_order_relaxed) == hash)
+            return true;
+    return false;
+}
+
+void transtable_insert(TransTable *t, uint64_t hash) {
+    _Atomic uint64_t *bucket = &t->slots[(hash & t->mask) * WAYS];
+    uint64_t old;
+    int i;
+
+    if (hash == EMPTY)
+        hash = 1;
+    for (i = 0; i < WAYS; i++) {
+        old = atomic_load_explicit(&bucket[i], memory_order_relaxed);
+        if (old == hash)
+            return;
+        if (old == EMPTY) {
+            atomic_store_explicit(&bucket[i], hash, memory_order_relaxed);
+            return;
+        }
+    }
+
+    // Balde cheio: substituir uma entrada escolhida pelos bits altos do
+    // hash, que não participam da escolha do balde
+    atomic_store_explicit(&bucket[hash >> 62], hash, memory_order_relaxed);
+}
+
+size_t transtable_capacity(const TransTable *t) {
+    return (t->mask + 1) * WAYS;
+}
+
+size_t transtable_entries(const TransTable *t, uint64_t *out) {
+    size_t i, n = 0;
+    uint64_t hash;
+
+    // Na ordem dos baldes e, em cada um, das entradas, que é a ordem em que
+    // transtable_insert as ocupa
+    for (i = 0; i < transtable_capacity(t); i++) {
+        hash = atomic_load_explicit(&t->slots[i], memory_order_relaxed);
+        if (hash != EMPTY)
+            out[n++] = hash;
+    }
+    return n;
+}
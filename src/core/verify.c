@@ -0,0 +1,209 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "core/futoshiki.h"
+#include "core/puzzle.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VERIFY_AVX2 1
+#endif
+
+// Grades verificadas juntas, uma por faixa de 32 bits de um registrador AVX2
+#define VERIFY_LANES 8
+
+// Maior tamanho cujas máscaras de valores cabem em uma faixa
+#define VERIFY_MAX_SIMD 32
+
+/*
+ * Condições que toda solução do tabuleiro deve satisfazer além de ser um
+ * quadrado latino, com as células dadas por seu índice na grade.
+ */
+typedef struct VerifyPlan {
+    size_t size;
+    size_t nCells;
+
+    // Células preenchidas do tabuleiro e seus valores
+    size_t nGivens;
+    size_t *givenCells;
+    uchar *givenValues;
+
+    // Pares de células em que a primeira deve ser menor que a segunda
+    size_t nConstr;
+    size_t *lo;
+    size_t *hi;
+} VerifyPlan;
+
+void _plan_init(VerifyPlan *plan, const Puzzle *p) {
+    Cell *c;
+    uchar i, j;
+    unsigned int k;
+
+    plan->size = p->size;
+    plan->nCells = (size_t) p->size * p->size;
+
+    plan->nGivens = 0;
+    plan->givenCells = malloc(plan->nCells * sizeof(*plan->givenCells));
+    plan->givenValues = malloc(plan->nCells);
+    for (i = 0; i < p->size; i++) {
+        for (j = 0; j < p->size; j++) {
+            if (p->cells[i][j]->val > 0) {
+                plan->givenCells[plan->nGivens] = i * plan->size + j;
+                plan->givenValues[plan->nGivens] = p->cells[i][j]->val;
+                plan->nGivens++;
+            }
+        }
+    }
+
+    plan->nConstr = 0;
+    plan->lo = malloc((p->nConstr + 1) * sizeof(*plan->lo));
+    plan->hi = malloc((p->nConstr + 1) * sizeof(*plan->hi));
+    for (i = 0; i < p->size; i++) {
+        for (j = 0; j < p->size; j++) {
+            c = p->cells[i][j];
+            for (k = 0; k < c->nGreater; k++) {
+                plan->lo[plan->nConstr] = CELL_INDEX(p, c);
+                plan->hi[plan->nConstr] = CELL_INDEX(p, c->greater[k]);
+                plan->nConstr++;
+            }
+        }
+    }
+}
+
+void _plan_destroy(VerifyPlan *plan) {
+    free(plan->givenCells);
+    free(plan->givenValues);
+    free(plan->lo);
+    free(plan->hi);
+}
+
+// Verificação de uma grade por vez, para qualquer tamanho. seen guarda, para
+// cada valor, o número da última linha ou coluna em que apareceu.
+bool _verify_scalar(const VerifyPlan *plan, const uchar *grid, size_t *seen) {
+    size_t n = plan->size, i, j, k, stamp = 0;
+    uchar v;
+
+    memset(seen, 0, (n + 1) * sizeof(*seen));
+    for (i = 0; i < n; i++) {
+        // Linha i
+        stamp++;
+        for (j = 0; j < n; j++) {
+            v = grid[i * n + j];
+            if (v == 0 || v > n || seen[v] == stamp)
+                return false;
+            seen[v] = stamp;
+        }
+
+        // Coluna i
+        stamp++;
+        for (j = 0; j < n; j++) {
+            v = grid[j * n + i];
+            if (v == 0 || v > n || seen[v] == stamp)
+                return false;
+            seen[v] = stamp;
+        }
+    }
+
+    for (k = 0; k < plan->nGivens; k++)
+        if (grid[plan->givenCells[k]] != plan->givenValues[k])
+            return false;
+    for (k = 0; k < plan->nConstr; k++)
+        if (grid[plan->lo[k]] >= grid[plan->hi[k]])
+            return false;
+    return true;
+}
+
+#ifdef VERIFY_AVX2
+
+// Verifica VERIFY_LANES grades de uma vez. Cada faixa acumula, por OU, a
+// máscara 1 << (v - 1) dos valores de uma linha ou coluna; a linha é válida
+// se e só se o resultado tem exatamente os size bits menores setados.
+// cells recebe as grades transpostas: um vetor de faixas por célula.
+// Retorna uma máscara com um bit por grade inválida.
+__attribute__((target("avx2")))
+int _verify_avx2(const VerifyPlan *plan, const uchar *grids, __m256i *cells) {
+    size_t n = plan->size, i, j, k;
+    const uchar *g[VERIFY_LANES];
+    __m256i one = _mm256_set1_epi32(1);
+    __m256i full = _mm256_set1_epi32(n == 32 ? -1 : (int) ((1u << n) - 1));
+    __m256i bad = _mm256_setzero_si256();
+    __m256i rowAcc, colAcc, v;
+
+    for (k = 0; k < VERIFY_LANES; k++)
+        g[k] = grids + k * plan->nCells;
+
+    // Transposição e conversão de cada valor em sua máscara; valores fora
+    // de 1..size deslocam para fora das faixas ou além de full
+    for (k = 0; k < plan->nCells; k++) {
+        v = _mm256_setr_epi32(g[0][k], g[1][k], g[2][k], g[3][k],
+                g[4][k], g[5][k], g[6][k], g[7][k]);
+        cells[k] = _mm256_sllv_epi32(one, _mm256_sub_epi32(v, one));
+    }
+
+    for (i = 0; i < n; i++) {
+        rowAcc = _mm256_setzero_si256();
+        colAcc = _mm256_setzero_si256();
+        for (j = 0; j < n; j++) {
+            rowAcc = _mm256_or_si256(rowAcc, cells[i * n + j]);
+            colAcc = _mm256_or_si256(colAcc, cells[j * n + i]);
+        }
+        bad = _mm256_or_si256(bad, _mm256_xor_si256(rowAcc, full));
+        bad = _mm256_or_si256(bad, _mm256_xor_si256(colAcc, full));
+    }
+
+    // Com as máscaras, a comparação de valores vira comparação de bits
+    for (k = 0; k < plan->nGivens; k++) {
+        v = _mm256_set1_epi32(1u << (plan->givenValues[k] - 1));
+        bad = _mm256_or_si256(bad, _mm256_xor_si256(cells[plan->givenCells[k]], v));
+    }
+    for (k = 0; k < plan->nConstr; k++) {
+        // Máscaras sem sinal comparadas após inverter o bit de sinal
+        v = _mm256_cmpgt_epi32(
+                _mm256_xor_si256(cells[plan->hi[k]], _mm256_set1_epi32(INT32_MIN)),
+                _mm256_xor_si256(cells[plan->lo[k]], _mm256_set1_epi32(INT32_MIN)));
+        bad = _mm256_or_si256(bad, _mm256_andnot_si256(v, _mm256_set1_epi32(-1)));
+    }
+
+    // Um bit por faixa com algum bit de bad setado
+    bad = _mm256_cmpeq_epi32(bad, _mm256_setzero_si256());
+    return ~_mm256_movemask_ps(_mm256_castsi256_ps(bad)) & ((1 << VERIFY_LANES) - 1);
+}
+
+#endif
+
+size_t puzzle_verifyBatch(const Puzzle *p, const unsigned char *grids, size_t count, bool *valid) {
+    VerifyPlan plan;
+    size_t *seen = malloc((p->size + 1) * sizeof(*seen));
+    size_t g = 0, nValid = 0;
+#ifdef VERIFY_AVX2
+    __m256i *cells;
+    int failed, k;
+#endif
+
+    _plan_init(&plan, p);
+
+#ifdef VERIFY_AVX2
+    if (p->size <= VERIFY_MAX_SIMD && __builtin_cpu_supports("avx2")) {
+        cells = aligned_alloc(sizeof(__m256i), plan.nCells * sizeof(__m256i));
+        for (; g + VERIFY_LANES <= count; g += VERIFY_LANES) {
+            failed = _verify_avx2(&plan, grids + g * plan.nCells, cells);
+            for (k = 0; k < VERIFY_LANES; k++)
+                valid[g + k] = !(failed & (1 << k));
+        }
+        free(cells);
+    }
+#endif
+
+    // Grades restantes, ou todas se não houver AVX2
+    for (; g < count; g++)
+        valid[g] = _verify_scalar(&plan, grids + g * plan.nCells, seen);
+
+    for (g = 0; g < count; g++)
+        nValid += valid[g];
+
+    _plan_destroy(&plan);
+    free(seen);
+    return nValid;
+}
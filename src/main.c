@@ -1,40 +1,754 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <inttypes.h>
 #include <time.h>
+#include <getopt.h>
+#include <signal.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <stdatomic.h>
 
 #include "core/futoshiki.h"
+#include "core/stats.h"
+#include "core/trace.h"
+#include "core/cache.h"
+#include "core/transtable.h"
+#include "core/checkpoint.h"
+#include "server/server.h"
+#include "server/shard.h"
 
 #define ASSIGN_MAX_EXC "Numero de atribuicoes excede limite maximo"
+#define TIMEOUT_EXC "Tempo limite excedido"
+#define CANCELLED_EXC "Busca interrompida"
+#define WORKER_EXC "Processo de trabalho interrompido"
 
-int main(void) {
+// Eventos mantidos por caso quando a busca é rastreada
+#define TRACE_DEFAULT_SIZE (1 << 20)
+
+// Casos lidos e resolvidos juntos no modo em lote
+#define BATCH_CASES 64
+
+// Tolerância, em milissegundos, além de -t antes de matar um processo de
+// trabalho que não desistiu sozinho do caso
+#define WORKER_GRACE 1000
+
+// Opções sem forma curta
+enum {
+    OPT_TRACE_CHROME = 256,
+    OPT_TRACE_FOLDED,
+    OPT_TRACE_SIZE,
+    OPT_THREADS,
+    OPT_TRANSPOSITIONS,
+    OPT_PROBE,
+    OPT_PROBE_BUDGET,
+    OPT_SEED,
+    OPT_CHECKPOINT,
+    OPT_CHECKPOINT_INTERVAL,
+    OPT_RESUME,
+    OPT_SPLIT,
+    OPT_MAX_ASSIGNMENTS
+};
+
+// Entrada completa do modo com processos de trabalho
+typedef struct ShardCases {
+    char *text;
+
+    // Início de cada caso em text; start[n] é o fim do último
+    size_t *start;
+    size_t n;
+
+    SolveOptions opts;
+    long timeout;
+    bool streaming;
+} ShardCases;
+
+// Setada por SIGINT/SIGTERM para encerrar o modo servidor
+static atomic_bool stopServer;
+
+static void _onSignal(int sig) {
+    (void) sig;
+    atomic_store(&stopServer, true);
+}
+
+// Executa o modo servidor até receber SIGINT ou SIGTERM
+int _serve(const char *path, int threads, const SolveOptions *opts, long timeout, SolveCache *cache) {
+    struct sigaction sa;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = _onSignal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    if (threads < 1)
+        threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (server_run(path, threads, opts, timeout, cache, &stopServer) < 0) {
+        perror(path);
+        return 1;
+    }
+    return 0;
+}
+
+// No modo contínuo, retorna se a entrada acabou antes de qualquer número de
+// um novo caso; um caso cortado no meio é inválido, e não o fim da entrada
+bool _inputEnded(void) {
+    int ch;
+
+    while ((ch = getchar()) != EOF && isspace(ch));
+    if (ch == EOF)
+        return true;
+    ungetc(ch, stdin);
+    return false;
+}
+
+// Exibe o resultado de um caso resolvido
+void _printResult(FILE *out, Puzzle *p, SolveStatus status, int64_t assignments, float seconds) {
+    if (status == SOLVE_LIMIT) {
+        fprintf(out, "%s\n", ASSIGN_MAX_EXC);
+    } else if (status == SOLVE_TIMEOUT) {
+        fprintf(out, "%s\n", TIMEOUT_EXC);
+    } else if (status == SOLVE_CANCELLED) {
+        fprintf(out, "%s\n", CANCELLED_EXC);
+    } else {
+        puzzle_display(p, out);
+        fprintf(out, "atribuicoes: %" PRId64 "\n", assignments);
+        fprintf(out, "tempo aproximado: %.3f segundos\n", seconds);
+    }
+}
+
+// Lê, para cada caso, o tabuleiro seguido do número de grades e das grades
+// a verificar, e informa se cada uma é solução do tabuleiro
+void _verifyCases(unsigned int ncases) {
+    unsigned int i, m, value;
+    unsigned int nValid = 0, total = 0;
+    size_t n, g, count;
+    unsigned char *grids;
+    bool *valid;
+    clock_t t;
+
+    for (i = 1; i <= ncases; i++) {
+        Puzzle *p = puzzle_new(stdin);
+        if (p == NULL || scanf("%u", &m) != 1) {
+            fprintf(stderr, "Entrada invalida no caso %u\n", i);
+            if (p != NULL)
+                puzzle_destroy(p);
+            break;
+        }
+
+        n = (size_t) puzzle_getSize(p) * puzzle_getSize(p);
+        grids = malloc(m * n + 1);
+        valid = malloc((m + 1) * sizeof(*valid));
+        for (count = 0; count < m * n && scanf("%u", &value) == 1; count++)
+            grids[count] = value > 255 ? 0 : value;
+
+        printf("%u\n", i);
+        t = clock();
+        nValid += puzzle_verifyBatch(p, grids, count / n, valid);
+        t = clock() - t;
+        total += m;
+        for (g = 0; g < m; g++)
+            printf("grade %zu: %s\n", g + 1, g < count / n && valid[g] ? "valida" : "invalida");
+        printf("tempo aproximado: %.3f segundos\n", ((float) t)/CLOCKS_PER_SEC);
+
+        free(grids);
+        free(valid);
+        puzzle_destroy(p);
+    }
+
+    printf("%u grades validas de %u\n", nValid, total);
+}
+
+// Estima o tamanho da busca de cada caso sem resolvê-lo, escrevendo uma
+// linha por caso com seu número, os nós estimados e o erro relativo
+void _estimateCases(unsigned int ncases, bool streaming, const SolveOptions *opts) {
+    SearchEstimate est;
+    unsigned int i;
+    Puzzle *p;
+
+    for (i = 1; streaming || i <= ncases; i++) {
+        if (streaming && _inputEnded())
+            break;
+        p = puzzle_new(stdin);
+        if (p == NULL) {
+            fprintf(stderr, "Entrada invalida no caso %u\n", i);
+            break;
+        }
+
+        est = puzzle_estimate(p, opts, ESTIMATE_PROBES);
+        printf("%u %.4g %.3f\n", i, est.nodes, est.error);
+        puzzle_destroy(p);
+
+        if (streaming)
+            fflush(stdout);
+    }
+}
+
+// Resolve os casos em lotes com puzzle_solveBatch, exibindo cada um como no
+// modo normal. Retorna o número de casos resolvidos.
+unsigned int _batchCases(unsigned int ncases, bool streaming, const SolveOptions *opts) {
+    Puzzle *ps[BATCH_CASES];
+    SolveStatus status[BATCH_CASES];
+    int64_t assignments[BATCH_CASES];
+    unsigned int i = 1, success = 0;
+    size_t n, k;
+    bool ended = false;
+    clock_t t;
+
+    while (!ended && (streaming || i <= ncases)) {
+        for (n = 0; n < BATCH_CASES && (streaming || i + n <= ncases); n++) {
+            if (streaming && _inputEnded()) {
+                ended = true;
+                break;
+            }
+            ps[n] = puzzle_new(stdin);
+            if (ps[n] == NULL) {
+                fprintf(stderr, "Entrada invalida no caso %zu\n", i + n);
+                ended = true;
+                break;
+            }
+            assignments[n] = 0;
+        }
+
+        t = clock();
+        success += puzzle_solveBatch(ps, n, opts, status, assignments);
+        t = clock() - t;
+
+        // O tempo do lote é dividido igualmente entre seus casos
+        for (k = 0; k < n; k++, i++) {
+            printf("%u\n", i);
+            _printResult(stdout, ps[k], status[k], assignments[k], ((float) t)/CLOCKS_PER_SEC/n);
+            puzzle_destroy(ps[k]);
+        }
+        if (streaming)
+            fflush(stdout);
+    }
+
+    return success;
+}
+
+// Lê toda a entrada e separa o texto de cada caso, parando no primeiro
+// inválido
+void _splitCases(ShardCases *cases) {
+    size_t len = 0, cap = 1 << 16, n, off = 0, ncases = SIZE_MAX;
+    char *end;
+    long caseLen;
+    Puzzle *p;
+
+    cases->text = malloc(cap + 1);
+    while ((n = fread(cases->text + len, 1, cap - len, stdin)) > 0) {
+        len += n;
+        if (len == cap) {
+            cap *= 2;
+            cases->text = realloc(cases->text, cap + 1);
+        }
+    }
+    cases->text[len] = '\0';
+
+    if (!cases->streaming) {
+        ncases = strtoul(cases->text, &end, 10);
+        off = end - cases->text;
+    }
+
+    cases->n = 0;
+    cases->start = malloc(sizeof(*cases->start));
+    cases->start[0] = off;
+    while (cases->n < ncases) {
+        caseLen = puzzle_textLength(cases->text + off, len - off, true);
+        p = caseLen > 0 ? puzzle_parse(cases->text + off, caseLen, NULL) : NULL;
+        if (p == NULL) {
+            // No modo contínuo, só espaços depois do último caso é o fim
+            // da entrada, e não um caso cortado
+            for (n = off; n < len && isspace((unsigned char) cases->text[n]); n++);
+            if (!cases->streaming || n < len)
+                fprintf(stderr, "Entrada invalida no caso %zu\n", cases->n + 1);
+            break;
+        }
+        puzzle_destroy(p);
+
+        off += caseLen;
+        cases->n++;
+        cases->start = realloc(cases->start, (cases->n + 1) * sizeof(*cases->start));
+        cases->start[cases->n] = off;
+    }
+}
+
+// Resolve o caso k em um processo de trabalho
+bool _shardSolve(size_t k, FILE *out, void *arg) {
+    ShardCases *cases = arg;
+    SolveOptions opts = cases->opts;
+    SolveStatus status;
+    int64_t assignments = 0;
+    clock_t t;
+    Puzzle *p;
+
+    p = puzzle_parse(cases->text + cases->start[k], cases->start[k + 1] - cases->start[k], NULL);
+    t = clock();
+    if (cases->timeout > 0)
+        opts.deadline = futoshiki_now() + (uint64_t) cases->timeout * 1000000;
+    status = puzzle_solve(p, &opts, &assignments);
+    t = clock() - t;
+    _printResult(out, p, status, assignments, ((float) t)/CLOCKS_PER_SEC);
+    puzzle_destroy(p);
+
+    return status == SOLVE_SOLVED;
+}
+
+// Exibe, na ordem dos casos, as respostas dos processos de trabalho
+void _shardPrint(size_t k, ShardOutcome outcome, const char *text, size_t len, void *arg) {
+    ShardCases *cases = arg;
+
+    printf("%zu\n", k + 1);
+    if (outcome == SHARD_CRASHED)
+        printf("%s\n", WORKER_EXC);
+    else if (outcome == SHARD_KILLED)
+        printf("%s\n", TIMEOUT_EXC);
+    else
+        fwrite(text, 1, len, stdout);
+
+    if (cases->streaming)
+        fflush(stdout);
+}
+
+// Resolve os casos em processos de trabalho, cada um com uma parte deles.
+// Retorna o número de casos resolvidos.
+unsigned int _shardCases(int workers, bool streaming, const SolveOptions *opts, long timeout) {
+    ShardCases cases;
+    long success;
+
+    cases.opts = *opts;
+    cases.timeout = timeout;
+    cases.streaming = streaming;
+    _splitCases(&cases);
+
+    success = shard_run(cases.n, workers, timeout > 0 ? timeout + WORKER_GRACE : 0,
+            _shardSolve, _shardPrint, &cases);
+
+    free(cases.start);
+    free(cases.text);
+    return success;
+}
+
+#define USAGE \
+    "Uso: %s [opcoes] < entrada\n" \
+    "  -p, --portfolio K   resolve cada caso com K threads concorrentes\n" \
+    "      --split K       divide a arvore de busca de cada caso entre K threads\n" \
+    "                      (ignorado com -p)\n" \
+    "  -t, --timeout MS    desiste de cada caso apos MS milissegundos\n" \
+    "      --max-assignments N  desiste de cada caso apos N atribuicoes (padrao\n" \
+    "                      1000000, 0 sem limite)\n" \
+    "  -j, --stats         escreve estatisticas de cada caso em JSON na saida\n" \
+    "                      de erro (requer make stats=1)\n" \
+    "      --trace-chrome ARQ  grava a arvore de busca de cada caso em ARQ,\n" \
+    "                      no formato de eventos do Chrome\n" \
+    "      --trace-folded ARQ  grava a arvore de busca como pilhas agregadas\n" \
+    "                      (flamegraph.pl, speedscope)\n" \
+    "      --trace-size N  eventos mantidos por caso (padrao 1048576)\n" \
+    "  -y, --symmetry      ignora solucoes simetricas a outras durante a busca\n" \
+    "      --probe D       antes de ramificar nos D primeiros niveis, descarta\n" \
+    "                      os valores cuja atribuicao leva a contradicao\n" \
+    "      --probe-budget N  valores testados por nivel (padrao 4096, 0 sem\n" \
+    "                      limite)\n" \
+    "  -l, --local         resolve por busca local, para grades grandes demais\n" \
+    "                      para o backtracking (ignora -p e -c; nao prova que\n" \
+    "                      um caso nao tem solucao)\n" \
+    "      --seed N        semente da busca local\n" \
+    "  -n, --count         conta as solucoes de cada caso em vez de exibir uma\n" \
+    "                      (ignora -p e -c)\n" \
+    "  -v, --verify        verifica grades dadas apos cada caso (numero de grades\n" \
+    "                      seguido das grades) em vez de resolve-lo\n" \
+    "  -e, --estimate      estima o tamanho da busca de cada caso sem resolve-lo:\n" \
+    "                      uma linha por caso com seu numero, os nos estimados\n" \
+    "                      e o erro relativo da estimativa\n" \
+    "  -g, --grade         resolve cada caso primeiro por deducao, sem busca, e\n" \
+    "                      informa sua dificuldade: a regra mais dificil\n" \
+    "                      necessaria (L1 a L4) ou \"busca\" quando a deducao\n" \
+    "                      nao basta (ignora -n; nao combina com --resume nem\n" \
+    "                      com --checkpoint)\n" \
+    "  -b, --batch         resolve ate 64 casos de cada vez, varios juntos por\n" \
+    "                      instrucao vetorial (ignora -p, -c, -n e -t)\n" \
+    "  -w, --workers N     divide os casos entre N processos, cada um em uma\n" \
+    "                      CPU; um processo que cai ou passa do limite de -t\n" \
+    "                      e substituido e so seu caso atual e perdido\n" \
+    "                      (ignora -p, -c, -n, -l, --checkpoint, --transpositions\n" \
+    "                      e rastreamento)\n" \
+    "  -s, --stream        le casos ate o fim da entrada, sem o numero de casos\n" \
+    "                      na primeira linha, e envia cada resposta assim que\n" \
+    "                      pronta\n" \
+    "      --checkpoint ARQ  salva periodicamente em ARQ o estado da busca do\n" \
+    "                      caso atual (ignorado com -p); o primeiro caso que\n" \
+    "                      desiste por -t ou limite de atribuicoes fica salvo\n" \
+    "      --checkpoint-interval S  segundos entre salvamentos (padrao 60)\n" \
+    "      --resume ARQ    continua do estado salvo em ARQ, pulando os casos\n" \
+    "                      anteriores ao salvo e salvando em ARQ se nao houver\n" \
+    "                      --checkpoint\n" \
+    "  -c, --cache N       guarda os resultados de ate N casos, reaproveitados\n" \
+    "                      por casos equivalentes por simetria\n" \
+    "      --transpositions N  guarda ate N grades sem solucao de cada caso,\n" \
+    "                      compartilhadas pelas threads de -p\n" \
+    "  -d, --daemon SOCK   atende requisicoes no socket Unix SOCK em vez de\n" \
+    "                      ler a entrada padrao\n" \
+    "      --threads N     threads do modo servidor (padrao: uma por CPU)\n"
+
+int main(int argc, char *argv[]) {
 
 	unsigned int i, ncases;
     unsigned int success = 0;
-    int assignments;
+    int64_t assignments;
+    int portfolio = 1;
+    int split = 1;
+    long timeout = 0;
+    int opt;
     clock_t t;
+    SolveOptions opts = solveoptions_default();
+    SolveStatus status;
+    SolveStats stats;
+    FILE *chromeFile = NULL, *foldedFile = NULL;
+    size_t traceSize = TRACE_DEFAULT_SIZE;
+    char label[32];
+    const char *socketPath = NULL;
+    int threads = 0;
+    int workers = 0;
+    SolveCache *cache = NULL;
+    uint64_t hits, misses;
+    int ret = 0;
+    bool counting = false;
+    bool verifying = false;
+    bool streaming = false;
+    bool batching = false;
+    bool local = false;
+    bool estimating = false;
+    bool grading = false;
+    DeductionGrade grade = GRADE_STALLED;
+    uint64_t count;
+    size_t transpositions = 0;
+    const char *resumeFile = NULL;
+    Checkpoint *resume = NULL;
 
-	scanf("%d", &ncases);
+    static const struct option longopts[] = {
+        {"portfolio", required_argument, NULL, 'p'},
+        {"split", required_argument, NULL, OPT_SPLIT},
+        {"timeout", required_argument, NULL, 't'},
+        {"max-assignments", required_argument, NULL, OPT_MAX_ASSIGNMENTS},
+        {"stats", no_argument, NULL, 'j'},
+        {"trace-chrome", required_argument, NULL, OPT_TRACE_CHROME},
+        {"trace-folded", required_argument, NULL, OPT_TRACE_FOLDED},
+        {"trace-size", required_argument, NULL, OPT_TRACE_SIZE},
+        {"symmetry", no_argument, NULL, 'y'},
+        {"count", no_argument, NULL, 'n'},
+        {"verify", no_argument, NULL, 'v'},
+        {"stream", no_argument, NULL, 's'},
+        {"batch", no_argument, NULL, 'b'},
+        {"workers", required_argument, NULL, 'w'},
+        {"local", no_argument, NULL, 'l'},
+        {"estimate", no_argument, NULL, 'e'},
+        {"grade", no_argument, NULL, 'g'},
+        {"seed", required_argument, NULL, OPT_SEED},
+        {"checkpoint", required_argument, NULL, OPT_CHECKPOINT},
+        {"checkpoint-interval", required_argument, NULL, OPT_CHECKPOINT_INTERVAL},
+        {"resume", required_argument, NULL, OPT_RESUME},
+        {"cache", required_argument, NULL, 'c'},
+        {"daemon", required_argument, NULL, 'd'},
+        {"threads", required_argument, NULL, OPT_THREADS},
+        {"transpositions", required_argument, NULL, OPT_TRANSPOSITIONS},
+        {"probe", required_argument, NULL, OPT_PROBE},
+        {"probe-budget", required_argument, NULL, OPT_PROBE_BUDGET},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
 
-	for(i = 1; i <= ncases; i++){
-	    Puzzle *p = puzzle_new(stdin);
+    while ((opt = getopt_long(argc, argv, "p:t:jynvsblegw:c:d:h", longopts, NULL)) != -1) {
+        switch (opt) {
+            case 'p':
+                portfolio = atoi(optarg);
+                break;
+            case OPT_SPLIT:
+                split = atoi(optarg);
+                break;
+            case 't':
+                timeout = atol(optarg);
+                break;
+            case OPT_MAX_ASSIGNMENTS:
+                opts.maxAssignments = strtoll(optarg, NULL, 10);
+                if (opts.maxAssignments <= 0)
+                    opts.maxAssignments = INT64_MAX;
+                break;
+            case 'j':
+#ifndef FUTOSHIKI_STATS
+                fprintf(stderr, "Estatisticas desabilitadas; compile com make stats=1\n");
+#endif
+                opts.stats = &stats;
+                break;
+            case OPT_TRACE_CHROME:
+                chromeFile = fopen(optarg, "w");
+                if (chromeFile == NULL) {
+                    perror(optarg);
+                    return 1;
+                }
+                break;
+            case OPT_TRACE_FOLDED:
+                foldedFile = fopen(optarg, "w");
+                if (foldedFile == NULL) {
+                    perror(optarg);
+                    return 1;
+                }
+                break;
+            case OPT_TRACE_SIZE:
+                traceSize = strtoul(optarg, NULL, 10);
+                break;
+            case 'y':
+                opts.config.symmetryBreaking = true;
+                break;
+            case 'n':
+                counting = true;
+                break;
+            case 'v':
+                verifying = true;
+                break;
+            case 's':
+                streaming = true;
+                break;
+            case 'b':
+                batching = true;
+                break;
+            case 'w':
+                workers = atoi(optarg);
+                break;
+            case 'l':
+                local = true;
+                break;
+            case 'e':
+                estimating = true;
+                break;
+            case 'g':
+                grading = true;
+                break;
+            case OPT_SEED:
+                opts.config.seed = strtoul(optarg, NULL, 10);
+                break;
+            case OPT_CHECKPOINT:
+                opts.checkpoint = optarg;
+                break;
+            case OPT_CHECKPOINT_INTERVAL:
+                opts.checkpointInterval = (uint64_t) (strtod(optarg, NULL) * 1e9);
+                break;
+            case OPT_RESUME:
+                resumeFile = optarg;
+                break;
+            case 'c':
+                if (cache != NULL)
+                    solvecache_destroy(cache);
+                cache = solvecache_new(strtoul(optarg, NULL, 10));
+                break;
+            case 'd':
+                socketPath = optarg;
+                break;
+            case OPT_THREADS:
+                threads = atoi(optarg);
+                break;
+            case OPT_TRANSPOSITIONS:
+                transpositions = strtoul(optarg, NULL, 10);
+                break;
+            case OPT_PROBE:
+                opts.config.probeDepth = strtoul(optarg, NULL, 10);
+                break;
+            case OPT_PROBE_BUDGET:
+                opts.config.probeBudget = strtoul(optarg, NULL, 10);
+                break;
+            default:
+                fprintf(stderr, USAGE, argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (socketPath != NULL) {
+        ret = _serve(socketPath, threads, &opts, timeout, cache);
+        if (cache != NULL)
+            solvecache_destroy(cache);
+        return ret;
+    }
+
+    if (verifying) {
+        scanf("%u", &ncases);
+        _verifyCases(ncases);
+        return 0;
+    }
+
+    if (estimating) {
+        if (!streaming)
+            scanf("%u", &ncases);
+        _estimateCases(ncases, streaming, &opts);
+        return 0;
+    }
+
+    if (batching) {
+        if (!streaming)
+            scanf("%u", &ncases);
+        printf("%u casos resolvidos\n", _batchCases(ncases, streaming, &opts));
+        return 0;
+    }
+
+    if (workers > 0) {
+        printf("%u casos resolvidos\n", _shardCases(workers, streaming, &opts, timeout));
+        return 0;
+    }
+
+    // O estado salvo é do tabuleiro antes da dedução, e um salvo depois
+    // dela não poderia ser retomado
+    if (grading && resumeFile != NULL) {
+        fprintf(stderr, "Opcoes -g e --resume nao combinam\n");
+        return 1;
+    }
+    if (grading && opts.checkpoint != NULL) {
+        fprintf(stderr, "Opcoes -g e --checkpoint nao combinam\n");
+        return 1;
+    }
+
+    if (resumeFile != NULL) {
+        resume = checkpoint_read(resumeFile);
+        if (resume == NULL) {
+            fprintf(stderr, "Estado salvo invalido: %s\n", resumeFile);
+            return 1;
+        }
+        if (opts.checkpoint == NULL)
+            opts.checkpoint = resumeFile;
+    }
+
+    if (chromeFile != NULL || foldedFile != NULL)
+        opts.trace = trace_new(traceSize);
+    if (transpositions > 0)
+        opts.transpositions = transtable_new(transpositions);
+    if (chromeFile != NULL)
+        fputs("{\"traceEvents\":[{\"name\":\"futoshiki\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"ts\":0}", chromeFile);
+
+    // No modo contínuo não há número de casos: lê-se até o fim da entrada
+    if (!streaming)
+	    scanf("%d", &ncases);
+
+	for(i = 1; streaming || i <= ncases; i++){
+        if (streaming && _inputEnded())
+            break;
+        Puzzle *p = puzzle_new(stdin);
+        if (p == NULL) {
+            fprintf(stderr, "Entrada invalida no caso %u\n", i);
+            break;
+        }
         assignments = 0;
 
+        // Os casos anteriores ao salvo já foram respondidos pela execução
+        // interrompida
+        if (resume != NULL && i < checkpoint_tag(resume)) {
+            puzzle_destroy(p);
+            continue;
+        }
+        opts.checkpointTag = i;
+        if (resume != NULL) {
+            if (!checkpoint_matches(resume, p, &opts.config, counting)) {
+                fprintf(stderr, "Estado salvo nao corresponde ao caso %u\n", i);
+                puzzle_destroy(p);
+                ret = 1;
+                break;
+            }
+            opts.resume = resume;
+        }
+
 	    printf("%d\n", i);
 
+        if (opts.trace != NULL)
+            trace_clear(opts.trace);
+        // As grades guardadas só valem para o tabuleiro em que foram achadas
+        if (opts.transpositions != NULL)
+            transtable_clear(opts.transpositions);
         t = clock();
-	    success += puzzle_solve(p, &assignments);
+        if (timeout > 0)
+            opts.deadline = futoshiki_now() + (uint64_t) timeout * 1000000;
+        // A busca só começa se a dedução parar antes de preencher a grade
+        if (grading && !counting)
+            grade = puzzle_deduce(p);
+        if (grade == GRADE_UNSAT)
+            status = SOLVE_UNSAT;
+        else if (grade != GRADE_STALLED)
+            status = SOLVE_SOLVED;
+        else if (counting)
+            status = puzzle_count(p, &opts, &count, &assignments);
+        else if (local)
+            status = puzzle_solveLocal(p, &opts, &assignments);
+        else if (cache != NULL)
+            status = solvecache_solve(cache, p, &opts, portfolio, &assignments);
+        else if (portfolio > 1)
+            status = puzzle_solvePortfolio(p, &opts, portfolio, &assignments);
+        else if (split > 1)
+            status = puzzle_solveSplit(p, &opts, split, &assignments);
+        else
+	        status = puzzle_solve(p, &opts, &assignments);
         t = clock() - t;
-        if (assignments < ASSIGN_MAX) {
-            puzzle_display(p, stdout);
-            printf("atribuicoes: %d\n", assignments);
+        success += status == SOLVE_SOLVED;
+        // O estado de um caso que não terminou fica salvo, e os casos
+        // seguintes não o sobrescrevem: retomá-lo refaz também os seguintes
+        if (status != SOLVE_SOLVED && status != SOLVE_UNSAT)
+            opts.checkpoint = NULL;
+        if (resume != NULL) {
+            checkpoint_destroy(resume);
+            resume = NULL;
+            opts.resume = NULL;
+        }
+        if (opts.stats != NULL)
+            solvestats_printJson(opts.stats, stderr);
+        if (chromeFile != NULL)
+            trace_exportChrome(opts.trace, chromeFile, i);
+        if (foldedFile != NULL) {
+            sprintf(label, "caso%u", i);
+            trace_exportFolded(opts.trace, foldedFile, label);
+        }
+        if (counting) {
+            printf("solucoes: %llu%s\n", (unsigned long long) count,
+                    status == SOLVE_SOLVED || status == SOLVE_UNSAT ? "" : " (parcial)");
+            printf("atribuicoes: %" PRId64 "\n", assignments);
             printf("tempo aproximado: %.3f segundos\n", ((float) t)/CLOCKS_PER_SEC);
         } else {
-            printf("%s\n", ASSIGN_MAX_EXC);
+            _printResult(stdout, p, status, assignments, ((float) t)/CLOCKS_PER_SEC);
+        }
+        if (grading && !counting) {
+            if (grade > GRADE_STALLED)
+                printf("dificuldade: L%d\n", grade);
+            else if (grade == GRADE_UNSAT)
+                printf("dificuldade: sem solucao\n");
+            else
+                printf("dificuldade: busca\n");
         }
 
 	    puzzle_destroy(p);
+
+        // Entregar a resposta antes de esperar pelo próximo caso
+        if (streaming)
+            fflush(stdout);
 	}
 
     printf("%u casos resolvidos\n", success);
-    return 0;
+
+    // Com todos os casos respondidos por completo o estado salvo não serve
+    // mais
+    if (opts.checkpoint != NULL && ret == 0)
+        remove(opts.checkpoint);
+    if (resume != NULL)
+        checkpoint_destroy(resume);
+
+    if (chromeFile != NULL) {
+        fputs("\n]}\n", chromeFile);
+        fclose(chromeFile);
+    }
+    if (foldedFile != NULL)
+        fclose(foldedFile);
+    if (opts.trace != NULL)
+        trace_destroy(opts.trace);
+    if (opts.transpositions != NULL)
+        transtable_destroy(opts.transpositions);
+    if (cache != NULL) {
+        solvecache_counters(cache, &hits, &misses);
+        fprintf(stderr, "cache: %llu acertos, %llu buscas\n",
+                (unsigned long long) hits, (unsigned long long) misses);
+        solvecache_destroy(cache);
+    }
+    return ret;
 }
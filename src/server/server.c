@@ -0,0 +1,521 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <inttypes.h>
+#include <time.h>
+#include <pthread.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "server/server.h"
+#include "core/futoshiki.h"
+#include "struct/list.h"
+
+// Tamanho inicial do buffer de leitura de cada conexão
+#define READ_CHUNK 4096
+
+// Intervalo, em milissegundos, entre checagens da flag de parada
+#define POLL_INTERVAL 200
+
+// Requisições de uma conexão recebidas e ainda não respondidas acima das
+// quais o leitor para de ler a conexão
+#define CONN_IN_FLIGHT 64
+
+// Tempo, em milissegundos, que o servidor espera ao encerrar para que as
+// respostas pendentes sejam lidas antes de fechar as conexões
+#define DRAIN_TIMEOUT 5000
+
+typedef struct Connection {
+    int fd;
+    struct Server *srv;
+
+    // Protege os campos abaixo
+    pthread_mutex_t lock;
+
+    // Leitor da conexão mais requisições ainda não respondidas; o escritor
+    // fecha a conexão quando chega a 0 e não há mais o que enviar
+    int refs;
+
+    // Requisições ainda não enviadas ao cliente, e a condição pela qual o
+    // leitor espera que fiquem abaixo de CONN_IN_FLIGHT
+    int inFlight;
+    pthread_cond_t room;
+
+    // Respostas prontas e ainda não enviadas, quantas requisições elas
+    // respondem, e a condição pela qual o escritor espera por elas
+    char *out;
+    size_t outLen;
+    size_t outCap;
+    int outAnswers;
+    pthread_cond_t pending;
+
+    // Setada quando um envio falha, descartando as respostas seguintes, ou
+    // quando o servidor é encerrado, descartando as requisições seguintes
+    bool broken;
+    bool closing;
+} Connection;
+
+typedef struct Job {
+    Connection *conn;
+    unsigned long seq;
+
+    char *text;
+    size_t len;
+
+    uint64_t received;
+} Job;
+
+typedef struct Server {
+    const SolveOptions *opts;
+    long timeout;
+
+    // Resultados compartilhados entre as threads (pode ser NULL)
+    SolveCache *cache;
+
+    pthread_mutex_t lock;
+
+    // Requisições esperando por uma thread
+    List *queue;
+    pthread_cond_t ready;
+    bool closing;
+
+    // Conexões ainda abertas, com quantas têm leitor e escritor ativos
+    List *conns;
+    int readers;
+    int writers;
+    pthread_cond_t idle;
+} Server;
+
+typedef struct ServerWorker {
+    Server *srv;
+    pthread_t thread;
+
+    // Tabuleiro reaproveitado entre requisições do mesmo tamanho
+    Puzzle *puzzle;
+    unsigned char *values;
+
+    // Resposta em construção
+    char *out;
+    size_t outCap;
+} ServerWorker;
+
+// Acrescenta uma resposta às que o escritor da conexão vai enviar; answer
+// indica se ela conclui uma requisição recebida
+void _conn_write(Connection *conn, const char *buf, size_t len, bool answer) {
+    pthread_mutex_lock(&conn->lock);
+    if (conn->broken) {
+        // Ninguém vai ler a resposta, mas o leitor pode estar esperando
+        if (answer) {
+            conn->inFlight--;
+            pthread_cond_signal(&conn->room);
+        }
+    } else {
+        if (conn->outLen + len > conn->outCap) {
+            conn->outCap = (conn->outLen + len) * 2;
+            conn->out = realloc(conn->out, conn->outCap);
+        }
+        memcpy(conn->out + conn->outLen, buf, len);
+        conn->outLen += len;
+        conn->outAnswers += answer;
+        pthread_cond_signal(&conn->pending);
+    }
+    pthread_mutex_unlock(&conn->lock);
+}
+
+void _conn_release(Connection *conn) {
+    pthread_mutex_lock(&conn->lock);
+    if (--conn->refs == 0)
+        pthread_cond_signal(&conn->pending);
+    pthread_mutex_unlock(&conn->lock);
+}
+
+// Retorna false, sem enfileirar a requisição, se o servidor está sendo
+// encerrado
+bool _server_push(Server *srv, Connection *conn, unsigned long seq, const char *text, size_t len) {
+    Job *job;
+
+    // Um cliente que envia sem ler as respostas deixa de ser lido, em vez
+    // de acumular requisições na fila sem limite
+    pthread_mutex_lock(&conn->lock);
+    while (conn->inFlight >= CONN_IN_FLIGHT && !conn->closing)
+        pthread_cond_wait(&conn->room, &conn->lock);
+    if (conn->closing) {
+        pthread_mutex_unlock(&conn->lock);
+        return false;
+    }
+    conn->inFlight++;
+    conn->refs++;
+    pthread_mutex_unlock(&conn->lock);
+
+    job = malloc(sizeof(*job));
+
+    job->conn = conn;
+    job->seq = seq;
+    job->text = malloc(len);
+    memcpy(job->text, text, len);
+    job->len = len;
+    job->received = futoshiki_now();
+
+    pthread_mutex_lock(&srv->lock);
+    list_append(srv->queue, job);
+    pthread_cond_signal(&srv->ready);
+    pthread_mutex_unlock(&srv->lock);
+    return true;
+}
+
+// Lê as requisições de uma conexão e as entrega às threads de trabalho
+void *_server_read(void *arg) {
+    Connection *conn = arg;
+    Server *srv = conn->srv;
+    size_t cap = READ_CHUNK, len = 0;
+    char *buf = malloc(cap);
+    unsigned long seq = 0;
+    ssize_t got;
+    long reqLen;
+    char msg[64];
+    bool eof = false;
+
+    while (!eof) {
+        if (len == cap) {
+            cap *= 2;
+            buf = realloc(buf, cap);
+        }
+        got = read(conn->fd, buf + len, cap - len);
+        if (got <= 0)
+            eof = true;
+        else
+            len += got;
+
+        // Extrair todas as requisições completas
+        while ((reqLen = puzzle_textLength(buf, len, eof)) > 0) {
+            if (!_server_push(srv, conn, seq++, buf, reqLen)) {
+                eof = true;
+                reqLen = 0;
+                break;
+            }
+            memmove(buf, buf + reqLen, len - reqLen);
+            len -= reqLen;
+        }
+
+        if (reqLen < 0) {
+            sprintf(msg, "%lu invalid 0 0\n", seq);
+            _conn_write(conn, msg, strlen(msg), false);
+            break;
+        }
+    }
+
+    free(buf);
+
+    pthread_mutex_lock(&srv->lock);
+    srv->readers--;
+    pthread_cond_signal(&srv->idle);
+    pthread_mutex_unlock(&srv->lock);
+
+    _conn_release(conn);
+    return NULL;
+}
+
+// Envia as respostas da conexão à medida que ficam prontas, de modo que um
+// cliente que não as lê prende só esta thread, e não as de trabalho
+void *_server_write(void *arg) {
+    Connection *conn = arg;
+    Server *srv = conn->srv;
+    size_t cap = 0, spare, len, done;
+    char *buf = NULL, *tmp;
+    ssize_t written;
+    int answers;
+    bool broken = false;
+
+    pthread_mutex_lock(&conn->lock);
+    for (;;) {
+        while (conn->outLen == 0 && conn->refs > 0)
+            pthread_cond_wait(&conn->pending, &conn->lock);
+        if (conn->outLen == 0)
+            break;
+
+        // Trocar de buffer, para que as threads de trabalho sigam
+        // escrevendo durante o envio
+        tmp = conn->out;
+        conn->out = buf;
+        buf = tmp;
+        spare = conn->outCap;
+        conn->outCap = cap;
+        cap = spare;
+        len = conn->outLen;
+        answers = conn->outAnswers;
+        conn->outLen = 0;
+        conn->outAnswers = 0;
+        pthread_mutex_unlock(&conn->lock);
+
+        for (done = 0; done < len && !broken; ) {
+            written = send(conn->fd, buf + done, len - done, MSG_NOSIGNAL);
+            if (written > 0)
+                done += written;
+            else if (written == 0 || errno != EINTR)
+                broken = true;
+        }
+
+        pthread_mutex_lock(&conn->lock);
+        conn->broken = broken;
+        conn->inFlight -= answers;
+        pthread_cond_signal(&conn->room);
+    }
+    pthread_mutex_unlock(&conn->lock);
+
+    free(buf);
+
+    pthread_mutex_lock(&srv->lock);
+    list_remove(srv->conns, conn);
+    srv->writers--;
+    pthread_cond_signal(&srv->idle);
+    pthread_mutex_unlock(&srv->lock);
+
+    close(conn->fd);
+    free(conn->out);
+    pthread_cond_destroy(&conn->pending);
+    pthread_cond_destroy(&conn->room);
+    pthread_mutex_destroy(&conn->lock);
+    free(conn);
+    return NULL;
+}
+
+// Garante espaço para mais n bytes na resposta
+void _worker_reserve(ServerWorker *w, size_t used, size_t n) {
+    if (used + n > w->outCap) {
+        w->outCap = (used + n) * 2;
+        w->out = realloc(w->out, w->outCap);
+    }
+}
+
+void _worker_answer(ServerWorker *w, Job *job) {
+    Server *srv = w->srv;
+    SolveOptions opts = *srv->opts;
+    SolveStatus status;
+    int64_t assignments = 0;
+    unsigned int i, j, size;
+    size_t used;
+
+    w->puzzle = puzzle_parseInto(w->puzzle, job->text, job->len, NULL);
+    if (w->puzzle == NULL) {
+        _worker_reserve(w, 0, 64);
+        used = sprintf(w->out, "%lu invalid %llu 0\n", job->seq,
+                (unsigned long long) (futoshiki_now() - job->received) / 1000);
+        _conn_write(job->conn, w->out, used, true);
+        return;
+    }
+
+    if (srv->timeout > 0)
+        opts.deadline = futoshiki_now() + (uint64_t) srv->timeout * 1000000;
+    if (srv->cache != NULL)
+        status = solvecache_solve(srv->cache, w->puzzle, &opts, 1, &assignments);
+    else
+        status = puzzle_solve(w->puzzle, &opts, &assignments);
+
+    size = puzzle_getSize(w->puzzle);
+    _worker_reserve(w, 0, 96 + (size_t) size * size * 4);
+    used = sprintf(w->out, "%lu %s %llu %" PRId64 "\n", job->seq, solvestatus_name(status),
+            (unsigned long long) (futoshiki_now() - job->received) / 1000, assignments);
+
+    if (status == SOLVE_SOLVED) {
+        puzzle_getValues(w->puzzle, w->values);
+        for (i = 0; i < size; i++) {
+            for (j = 0; j < size; j++)
+                used += sprintf(w->out + used, "%u ", w->values[i * size + j]);
+            w->out[used++] = '\n';
+        }
+    }
+
+    _conn_write(job->conn, w->out, used, true);
+}
+
+void *_server_work(void *arg) {
+    ServerWorker *w = arg;
+    Server *srv = w->srv;
+    Job *job;
+
+    while (true) {
+        pthread_mutex_lock(&srv->lock);
+        while (list_length(srv->queue) == 0 && !srv->closing)
+            pthread_cond_wait(&srv->ready, &srv->lock);
+        if (list_length(srv->queue) == 0) {
+            pthread_mutex_unlock(&srv->lock);
+            break;
+        }
+        job = list_removeFirst(srv->queue);
+        pthread_mutex_unlock(&srv->lock);
+
+        _worker_answer(w, job);
+        _conn_release(job->conn);
+        free(job->text);
+        free(job);
+    }
+
+    return NULL;
+}
+
+int _server_listen(const char *path) {
+    struct sockaddr_un addr;
+    int fd;
+
+    if (strlen(path) >= sizeof(addr.sun_path))
+        return -1;
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path);
+
+    if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0 || listen(fd, SOMAXCONN) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int server_run(const char *path, int nWorkers, const SolveOptions *opts, long timeout,
+        SolveCache *cache, const atomic_bool *stop) {
+    Server srv;
+    SolveOptions defaults;
+    ServerWorker *workers;
+    ListIterator *iter;
+    Connection *conn;
+    pthread_t thread;
+    struct pollfd pfd;
+    struct timespec drain;
+    int listenFd, fd, i;
+
+    if (opts == NULL) {
+        defaults = solveoptions_default();
+        opts = &defaults;
+    }
+    if (nWorkers < 1)
+        nWorkers = 1;
+
+    listenFd = _server_listen(path);
+    if (listenFd < 0)
+        return -1;
+
+    srv.opts = opts;
+    srv.timeout = timeout;
+    srv.cache = cache;
+    srv.queue = list_new();
+    srv.conns = list_new();
+    srv.closing = false;
+    srv.readers = 0;
+    srv.writers = 0;
+    pthread_mutex_init(&srv.lock, NULL);
+    pthread_cond_init(&srv.ready, NULL);
+    pthread_cond_init(&srv.idle, NULL);
+
+    // Threads e memória de trabalho alocadas antes da primeira conexão
+    workers = malloc(nWorkers * sizeof(*workers));
+    for (i = 0; i < nWorkers; i++) {
+        workers[i].srv = &srv;
+        workers[i].puzzle = NULL;
+        workers[i].values = malloc(UCHAR_MAX * UCHAR_MAX);
+        workers[i].outCap = READ_CHUNK;
+        workers[i].out = malloc(workers[i].outCap);
+        pthread_create(&workers[i].thread, NULL, _server_work, &workers[i]);
+    }
+
+    pfd.fd = listenFd;
+    pfd.events = POLLIN;
+    while (!atomic_load(stop)) {
+        if (poll(&pfd, 1, POLL_INTERVAL) <= 0)
+            continue;
+        fd = accept(listenFd, NULL, NULL);
+        if (fd < 0)
+            continue;
+
+        conn = malloc(sizeof(*conn));
+        conn->fd = fd;
+        conn->srv = &srv;
+        conn->refs = 1;
+        conn->inFlight = 0;
+        conn->out = NULL;
+        conn->outLen = 0;
+        conn->outCap = 0;
+        conn->outAnswers = 0;
+        conn->broken = false;
+        conn->closing = false;
+        pthread_mutex_init(&conn->lock, NULL);
+        pthread_cond_init(&conn->room, NULL);
+        pthread_cond_init(&conn->pending, NULL);
+
+        pthread_mutex_lock(&srv.lock);
+        list_append(srv.conns, conn);
+        srv.readers++;
+        srv.writers++;
+        pthread_mutex_unlock(&srv.lock);
+
+        pthread_create(&thread, NULL, _server_read, conn);
+        pthread_detach(thread);
+        pthread_create(&thread, NULL, _server_write, conn);
+        pthread_detach(thread);
+    }
+
+    close(listenFd);
+    unlink(path);
+
+    // Encerrar a leitura das conexões abertas, inclusive a dos leitores
+    // esperando que um cliente leia suas respostas, e esperar os leitores
+    pthread_mutex_lock(&srv.lock);
+    iter = list_iterator(srv.conns);
+    while (listiter_hasNext(iter)) {
+        conn = listiter_next(iter);
+        shutdown(conn->fd, SHUT_RD);
+        pthread_mutex_lock(&conn->lock);
+        conn->closing = true;
+        pthread_cond_signal(&conn->room);
+        pthread_mutex_unlock(&conn->lock);
+    }
+    listiter_destroy(iter);
+    while (srv.readers > 0)
+        pthread_cond_wait(&srv.idle, &srv.lock);
+
+    // Responder o que ainda estiver na fila e encerrar as threads
+    srv.closing = true;
+    pthread_cond_broadcast(&srv.ready);
+    pthread_mutex_unlock(&srv.lock);
+
+    for (i = 0; i < nWorkers; i++) {
+        pthread_join(workers[i].thread, NULL);
+        if (workers[i].puzzle != NULL)
+            puzzle_destroy(workers[i].puzzle);
+        free(workers[i].values);
+        free(workers[i].out);
+    }
+    free(workers);
+
+    // Dar aos clientes um tempo para ler as últimas respostas, e então
+    // fechar as conexões de quem não as lê
+    clock_gettime(CLOCK_REALTIME, &drain);
+    drain.tv_sec += DRAIN_TIMEOUT / 1000;
+    pthread_mutex_lock(&srv.lock);
+    while (srv.writers > 0 && pthread_cond_timedwait(&srv.idle, &srv.lock, &drain) == 0);
+    iter = list_iterator(srv.conns);
+    while (listiter_hasNext(iter))
+        shutdown(((Connection *) listiter_next(iter))->fd, SHUT_RDWR);
+    listiter_destroy(iter);
+    while (srv.writers > 0)
+        pthread_cond_wait(&srv.idle, &srv.lock);
+    pthread_mutex_unlock(&srv.lock);
+
+    list_destroy(srv.queue);
+    list_destroy(srv.conns);
+    pthread_cond_destroy(&srv.idle);
+    pthread_cond_destroy(&srv.ready);
+    pthread_mutex_destroy(&srv.lock);
+
+    return 0;
+}
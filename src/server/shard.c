@@ -0,0 +1,338 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "server/shard.h"
+#include "core/futoshiki.h"
+
+// Tamanho mínimo livre no buffer de leitura de cada worker
+#define READ_CHUNK 4096
+
+// Intervalo, em milissegundos, entre checagens do limite de tempo
+#define POLL_INTERVAL 100
+
+// Cabeçalho de cada resposta enviada pelo pipe, seguido de len bytes
+typedef struct ShardFrame {
+    uint64_t index;
+    uint32_t ok;
+    uint32_t len;
+} ShardFrame;
+
+typedef struct ShardWorker {
+    pid_t pid;
+    int fd;
+
+    // Caso em andamento e quando o coordenador o viu começar
+    size_t next;
+    uint64_t started;
+    bool killed;
+
+    // Respostas recebidas e ainda incompletas
+    char *buf;
+    size_t len, cap;
+} ShardWorker;
+
+typedef struct ShardResult {
+    char *text;
+    size_t len;
+    ShardOutcome outcome;
+    bool ready;
+} ShardResult;
+
+typedef struct Shard {
+    size_t nCases;
+    int nWorkers;
+    ShardJob job;
+    ShardEmit emit;
+    void *ctx;
+
+    ShardWorker *workers;
+
+    // Respostas que chegaram antes das anteriores a elas
+    ShardResult *results;
+    size_t emitted;
+    long success;
+} Shard;
+
+// Fixa o processo na slot-ésima CPU das permitidas, circularmente
+void _shard_pin(int slot) {
+#ifdef __linux__
+    cpu_set_t allowed, set;
+    int cpu, n;
+
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+        return;
+    n = slot % CPU_COUNT(&allowed);
+    for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &allowed) && n-- == 0) {
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            sched_setaffinity(0, sizeof(set), &set);
+            return;
+        }
+    }
+#else
+    (void) slot;
+#endif
+}
+
+void _shard_writeAll(int fd, const void *data, size_t len) {
+    const char *p = data;
+    ssize_t n;
+
+    while (len > 0) {
+        n = write(fd, p, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        // Sem o coordenador não há a quem responder
+        if (n <= 0)
+            _exit(1);
+        p += n;
+        len -= n;
+    }
+}
+
+// Corpo do worker: resolve os casos de sua parte a partir de first
+void _shard_child(Shard *sh, int fd, size_t first) {
+    ShardFrame frame;
+    char *text;
+    size_t len, k;
+    FILE *out;
+
+    for (k = first; k < sh->nCases; k += sh->nWorkers) {
+        text = NULL;
+        len = 0;
+        out = open_memstream(&text, &len);
+        if (out == NULL)
+            _exit(1);
+        frame.ok = sh->job(k, out, sh->ctx);
+        fclose(out);
+
+        frame.index = k;
+        frame.len = len;
+        _shard_writeAll(fd, &frame, sizeof(frame));
+        _shard_writeAll(fd, text, len);
+        free(text);
+    }
+    _exit(0);
+}
+
+void _shard_store(Shard *sh, size_t k, ShardOutcome outcome, const char *text, size_t len) {
+    ShardResult *r = &sh->results[k];
+
+    r->text = malloc(len + 1);
+    if (len > 0)
+        memcpy(r->text, text, len);
+    r->len = len;
+    r->outcome = outcome;
+    r->ready = true;
+}
+
+// Entrega as respostas prontas que não esperam por nenhuma anterior
+void _shard_flush(Shard *sh) {
+    ShardResult *r;
+
+    while (sh->emitted < sh->nCases && sh->results[sh->emitted].ready) {
+        r = &sh->results[sh->emitted];
+        sh->emit(sh->emitted, r->outcome, r->text, r->len, sh->ctx);
+        sh->success += r->outcome == SHARD_OK;
+        free(r->text);
+        r->text = NULL;
+        sh->emitted++;
+    }
+}
+
+// Cria o worker da parte slot a partir de w->next. Se não for possível, os
+// casos restantes da parte são dados como perdidos.
+void _shard_start(Shard *sh, int slot) {
+    ShardWorker *w = &sh->workers[slot];
+    int fds[2];
+
+    w->pid = -1;
+    for (; w->next < sh->nCases; w->next += sh->nWorkers) {
+        if (pipe(fds) == 0) {
+            // O filho herda os buffers de saída: esvaziados antes para não
+            // serem escritos duas vezes
+            fflush(NULL);
+            w->pid = fork();
+            if (w->pid == 0) {
+                close(fds[0]);
+                _shard_pin(slot);
+                _shard_child(sh, fds[1], w->next);
+            }
+            close(fds[1]);
+            if (w->pid > 0) {
+                w->fd = fds[0];
+                w->started = futoshiki_now();
+                w->killed = false;
+                w->len = 0;
+                return;
+            }
+            close(fds[0]);
+        }
+        _shard_store(sh, w->next, SHARD_CRASHED, NULL, 0);
+    }
+}
+
+// Separa as respostas completas no buffer do worker
+void _shard_receive(Shard *sh, ShardWorker *w) {
+    ShardFrame frame;
+    size_t pos = 0;
+
+    while (w->len - pos >= sizeof(frame)) {
+        memcpy(&frame, w->buf + pos, sizeof(frame));
+        if (w->len - pos - sizeof(frame) < frame.len)
+            break;
+        pos += sizeof(frame);
+        _shard_store(sh, frame.index, frame.ok ? SHARD_OK : SHARD_FAILED, w->buf + pos, frame.len);
+        pos += frame.len;
+
+        w->next = frame.index + sh->nWorkers;
+        w->started = futoshiki_now();
+    }
+    memmove(w->buf, w->buf + pos, w->len - pos);
+    w->len -= pos;
+}
+
+// Fim do pipe do worker: se a parte não acabou, o caso em andamento é dado
+// como perdido e um novo worker segue do próximo
+void _shard_lost(Shard *sh, int slot) {
+    ShardWorker *w = &sh->workers[slot];
+    int status;
+
+    close(w->fd);
+    waitpid(w->pid, &status, 0);
+    w->pid = -1;
+    if (w->next >= sh->nCases)
+        return;
+
+    _shard_store(sh, w->next, w->killed ? SHARD_KILLED : SHARD_CRASHED, NULL, 0);
+    w->next += sh->nWorkers;
+    _shard_start(sh, slot);
+}
+
+void _shard_read(Shard *sh, int slot) {
+    ShardWorker *w = &sh->workers[slot];
+    ssize_t n;
+
+    if (w->cap - w->len < READ_CHUNK) {
+        w->cap = 2 * w->cap + READ_CHUNK;
+        w->buf = realloc(w->buf, w->cap);
+    }
+
+    n = read(w->fd, w->buf + w->len, w->cap - w->len);
+    if (n > 0) {
+        w->len += n;
+        _shard_receive(sh, w);
+    } else if (n == 0 || errno != EINTR) {
+        _shard_lost(sh, slot);
+    }
+}
+
+// Encerra os workers quando não é mais possível esperar por eles: os casos
+// que faltam de cada parte são dados como perdidos, e as respostas já
+// recebidas são entregues
+void _shard_abort(Shard *sh) {
+    ShardWorker *w;
+    int i, status;
+
+    for (i = 0; i < sh->nWorkers; i++) {
+        w = &sh->workers[i];
+        if (w->pid > 0) {
+            kill(w->pid, SIGKILL);
+            close(w->fd);
+            waitpid(w->pid, &status, 0);
+            w->pid = -1;
+        }
+        for (; w->next < sh->nCases; w->next += sh->nWorkers)
+            _shard_store(sh, w->next, SHARD_CRASHED, NULL, 0);
+    }
+    _shard_flush(sh);
+}
+
+long shard_run(size_t nCases, int nWorkers, long limit, ShardJob job, ShardEmit emit, void *ctx) {
+    Shard sh;
+    struct pollfd *fds;
+    int *slots;
+    int i, n;
+    uint64_t now;
+
+    if (nCases == 0)
+        return 0;
+    if (nWorkers < 1)
+        nWorkers = 1;
+    if ((size_t) nWorkers > nCases)
+        nWorkers = nCases;
+
+    sh.nCases = nCases;
+    sh.nWorkers = nWorkers;
+    sh.job = job;
+    sh.emit = emit;
+    sh.ctx = ctx;
+    sh.workers = calloc(nWorkers, sizeof(*sh.workers));
+    sh.results = calloc(nCases, sizeof(*sh.results));
+    sh.emitted = 0;
+    sh.success = 0;
+    fds = malloc(nWorkers * sizeof(*fds));
+    slots = malloc(nWorkers * sizeof(*slots));
+
+    for (i = 0; i < nWorkers; i++) {
+        sh.workers[i].next = i;
+        _shard_start(&sh, i);
+    }
+
+    for (;;) {
+        _shard_flush(&sh);
+
+        n = 0;
+        for (i = 0; i < nWorkers; i++) {
+            if (sh.workers[i].pid > 0) {
+                fds[n].fd = sh.workers[i].fd;
+                fds[n].events = POLLIN;
+                slots[n++] = i;
+            }
+        }
+        if (n == 0)
+            break;
+
+        // Interrompido por um sinal, poll não diz nada sobre os pipes
+        if (poll(fds, n, limit > 0 ? POLL_INTERVAL : -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            _shard_abort(&sh);
+            break;
+        }
+        for (i = 0; i < n; i++)
+            if (fds[i].revents != 0)
+                _shard_read(&sh, slots[i]);
+
+        // O worker morto é notado pelo fim do seu pipe
+        now = futoshiki_now();
+        for (i = 0; limit > 0 && i < nWorkers; i++) {
+            ShardWorker *w = &sh.workers[i];
+            if (w->pid > 0 && !w->killed && now - w->started > (uint64_t) limit * 1000000) {
+                kill(w->pid, SIGKILL);
+                w->killed = true;
+            }
+        }
+    }
+
+    for (i = 0; i < nWorkers; i++)
+        free(sh.workers[i].buf);
+    free(sh.workers);
+    free(sh.results);
+    free(fds);
+    free(slots);
+    return sh.success;
+}
@@ -0,0 +1,171 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "struct/bitset.h"
+
+#define WORD_BITS 64
+#define _word(i) ((i) / WORD_BITS)
+#define _bit(i) ((uint64_t) 1 << ((i) % WORD_BITS))
+
+struct BitSet {
+    uint64_t *words;
+    size_t nWords;
+    size_t nBits;
+
+    // Bits válidos da última palavra; os demais ficam sempre em 0
+    uint64_t lastMask;
+};
+
+BitSet *bitset_new(size_t nBits) {
+    BitSet *a = malloc(sizeof(*a));
+
+    a->nBits = nBits;
+    a->nWords = (nBits + WORD_BITS - 1) / WORD_BITS;
+    a->words = calloc(a->nWords > 0 ? a->nWords : 1, sizeof(*a->words));
+    a->lastMask = nBits % WORD_BITS == 0 ? UINT64_MAX : _bit(nBits) - 1;
+
+    return a;
+}
+
+void bitset_destroy(BitSet *a) {
+    free(a->words);
+    free(a);
+}
+
+size_t bitset_getNBits(const BitSet *a) {
+    return a->nBits;
+}
+
+bool bitset_check(const BitSet *a, size_t i) {
+    return (a->words[_word(i)] & _bit(i)) != 0;
+}
+
+void bitset_set(BitSet *a, size_t i) {
+    a->words[_word(i)] |= _bit(i);
+}
+
+void bitset_clear(BitSet *a, size_t i) {
+    a->words[_word(i)] &= ~_bit(i);
+}
+
+void bitset_toggle(BitSet *a, size_t i) {
+    a->words[_word(i)] ^= _bit(i);
+}
+
+void bitset_setAll(BitSet *a) {
+    if (a->nWords == 0)
+        return;
+    memset(a->words, 0xff, a->nWords * sizeof(*a->words));
+    a->words[a->nWords - 1] = a->lastMask;
+}
+
+void bitset_clearAll(BitSet *a) {
+    memset(a->words, 0, a->nWords * sizeof(*a->words));
+}
+
+void bitset_toggleAll(BitSet *a) {
+    size_t w;
+
+    if (a->nWords == 0)
+        return;
+    for (w = 0; w < a->nWords; w++)
+        a->words[w] = ~a->words[w];
+    a->words[a->nWords - 1] &= a->lastMask;
+}
+
+void bitset_and(BitSet *a, const BitSet *b) {
+    size_t w;
+
+    for (w = 0; w < a->nWords; w++)
+        a->words[w] &= b->words[w];
+}
+
+void bitset_or(BitSet *a, const BitSet *b) {
+    size_t w;
+
+    for (w = 0; w < a->nWords; w++)
+        a->words[w] |= b->words[w];
+}
+
+void bitset_andNot(BitSet *a, const BitSet *b) {
+    size_t w;
+
+    for (w = 0; w < a->nWords; w++)
+        a->words[w] &= ~b->words[w];
+}
+
+void bitset_xor(BitSet *a, const BitSet *b) {
+    size_t w;
+
+    for (w = 0; w < a->nWords; w++)
+        a->words[w] ^= b->words[w];
+}
+
+void bitset_copy(BitSet *a, const BitSet *b) {
+    memcpy(a->words, b->words, a->nWords * sizeof(*a->words));
+}
+
+size_t bitset_count(const BitSet *a) {
+    size_t w, n = 0;
+
+    for (w = 0; w < a->nWords; w++)
+        n += __builtin_popcountll(a->words[w]);
+    return n;
+}
+
+size_t bitset_first(const BitSet *a) {
+    return bitset_next(a, 0);
+}
+
+size_t bitset_next(const BitSet *a, size_t i) {
+    size_t w = _word(i);
+    uint64_t bits;
+
+    if (i >= a->nBits)
+        return BITSET_NONE;
+
+    // Descartar os bits abaixo de i na primeira palavra
+    bits = a->words[w] & (UINT64_MAX << (i % WORD_BITS));
+    while (bits == 0) {
+        if (++w == a->nWords)
+            return BITSET_NONE;
+        bits = a->words[w];
+    }
+    return w * WORD_BITS + __builtin_ctzll(bits);
+}
+
+bool bitset_isEmpty(const BitSet *a) {
+    size_t w;
+
+    for (w = 0; w < a->nWords; w++)
+        if (a->words[w] != 0)
+            return false;
+    return true;
+}
+
+bool bitset_equals(const BitSet *a, const BitSet *b) {
+    return memcmp(a->words, b->words, a->nWords * sizeof(*a->words)) == 0;
+}
+
+bool bitset_isSubset(const BitSet *a, const BitSet *b) {
+    size_t w;
+
+    for (w = 0; w < a->nWords; w++)
+        if (a->words[w] & ~b->words[w])
+            return false;
+    return true;
+}
+
+bool bitset_intersects(const BitSet *a, const BitSet *b) {
+    size_t w;
+
+    for (w = 0; w < a->nWords; w++)
+        if (a->words[w] & b->words[w])
+            return true;
+    return false;
+}
+
+#undef _bit
+#undef _word
+#undef WORD_BITS
@@ -205,3 +205,156 @@ bool heap_isEmpty(const Heap *h) {
 size_t heap_getSize(const Heap *h) {
     return h->size;
 }
+
+
+
+struct IndexHeap {
+    // Ids na ordem do heap: os filhos da posição i estão em 2i+1 e 2i+2
+    size_t *ids;
+    size_t size;
+    size_t capacity;
+
+    // Posição de cada id em ids, ou INDEXHEAP_NONE se não estiver no heap
+    size_t *pos;
+    long *priority;
+};
+
+// Se o id a deve ficar acima do id b
+#define _indexheap_before(h, a, b) \
+    ((h)->priority[a] < (h)->priority[b] \
+     || ((h)->priority[a] == (h)->priority[b] && (a) < (b)))
+
+IndexHeap *indexheap_new(size_t capacity) {
+    IndexHeap *h = malloc(sizeof(*h));
+    size_t i;
+
+    h->ids = malloc(capacity * sizeof(*h->ids));
+    h->pos = malloc(capacity * sizeof(*h->pos));
+    h->priority = malloc(capacity * sizeof(*h->priority));
+    h->capacity = capacity;
+    h->size = 0;
+    for (i = 0; i < capacity; i++)
+        h->pos[i] = INDEXHEAP_NONE;
+
+    return h;
+}
+
+void indexheap_destroy(IndexHeap *h) {
+    free(h->ids);
+    free(h->pos);
+    free(h->priority);
+    free(h);
+}
+
+void indexheap_clear(IndexHeap *h) {
+    size_t i;
+
+    for (i = 0; i < h->size; i++)
+        h->pos[h->ids[i]] = INDEXHEAP_NONE;
+    h->size = 0;
+}
+
+// Sobe o id da posição i até o seu lugar. Os ids no caminho descem uma
+// posição cada, sem trocas: o id só é escrito na posição final.
+void _indexheap_up(IndexHeap *h, size_t i) {
+    size_t id = h->ids[i], parent;
+
+    while (i > 0) {
+        parent = (i - 1) / 2;
+        if (!_indexheap_before(h, id, h->ids[parent]))
+            break;
+        h->ids[i] = h->ids[parent];
+        h->pos[h->ids[i]] = i;
+        i = parent;
+    }
+    h->ids[i] = id;
+    h->pos[id] = i;
+}
+
+// Análogo à função acima, descendo o id em direção às folhas
+void _indexheap_down(IndexHeap *h, size_t i) {
+    size_t id = h->ids[i], child;
+
+    while ((child = 2 * i + 1) < h->size) {
+        if (child + 1 < h->size && _indexheap_before(h, h->ids[child + 1], h->ids[child]))
+            child++;
+        if (!_indexheap_before(h, h->ids[child], id))
+            break;
+        h->ids[i] = h->ids[child];
+        h->pos[h->ids[i]] = i;
+        i = child;
+    }
+    h->ids[i] = id;
+    h->pos[id] = i;
+}
+
+void indexheap_push(IndexHeap *h, size_t id, long priority) {
+    long old;
+
+    if (h->pos[id] == INDEXHEAP_NONE) {
+        h->priority[id] = priority;
+        h->ids[h->size] = id;
+        _indexheap_up(h, h->size++);
+        return;
+    }
+
+    old = h->priority[id];
+    h->priority[id] = priority;
+    if (priority < old)
+        _indexheap_up(h, h->pos[id]);
+    else if (priority > old)
+        _indexheap_down(h, h->pos[id]);
+}
+
+// Retira o id da posição i, pondo o último id em seu lugar
+void _indexheap_removeAt(IndexHeap *h, size_t i) {
+    size_t last;
+
+    h->pos[h->ids[i]] = INDEXHEAP_NONE;
+    if (i == --h->size)
+        return;
+
+    last = h->ids[h->size];
+    h->ids[i] = last;
+    h->pos[last] = i;
+    if (i > 0 && _indexheap_before(h, last, h->ids[(i - 1) / 2]))
+        _indexheap_up(h, i);
+    else
+        _indexheap_down(h, i);
+}
+
+size_t indexheap_pop(IndexHeap *h) {
+    size_t id;
+
+    if (h->size == 0)
+        return INDEXHEAP_NONE;
+
+    id = h->ids[0];
+    _indexheap_removeAt(h, 0);
+    return id;
+}
+
+size_t indexheap_peek(const IndexHeap *h) {
+    return h->size == 0 ? INDEXHEAP_NONE : h->ids[0];
+}
+
+void indexheap_remove(IndexHeap *h, size_t id) {
+    if (h->pos[id] != INDEXHEAP_NONE)
+        _indexheap_removeAt(h, h->pos[id]);
+}
+
+bool indexheap_contains(const IndexHeap *h, size_t id) {
+    return h->pos[id] != INDEXHEAP_NONE;
+}
+
+long indexheap_priority(const IndexHeap *h, size_t id) {
+    return h->priority[id];
+}
+
+bool indexheap_isEmpty(const IndexHeap *h) {
+    return h->size == 0;
+}
+
+size_t indexheap_getSize(const IndexHeap *h) {
+    return h->size;
+}
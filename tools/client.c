@@ -0,0 +1,70 @@
+/*
+ * Cliente simples do modo servidor: envia os casos da entrada padrão (no
+ * mesmo formato lido pelo Futoshiki, com o número de casos na primeira
+ * linha) ao socket dado e escreve as respostas na saída padrão.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "core/futoshiki.h"
+
+int connectTo(const char *path) {
+    struct sockaddr_un addr;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    if (fd < 0 || connect(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+        perror(path);
+        exit(1);
+    }
+    return fd;
+}
+
+int main(int argc, char *argv[]) {
+    size_t cap = 4096, len = 0, pos = 0;
+    char *buf = malloc(cap);
+    char out[4096];
+    ssize_t got;
+    int fd;
+
+    if (argc != 2) {
+        fprintf(stderr, "Uso: %s SOCKET < entrada\n", argv[0]);
+        return 1;
+    }
+
+    while ((got = fread(buf + len, 1, cap - len, stdin)) > 0) {
+        len += got;
+        if (len == cap) {
+            cap *= 2;
+            buf = realloc(buf, cap);
+        }
+    }
+
+    // Pular o número de casos
+    while (pos < len && (buf[pos] == ' ' || buf[pos] == '\n' || buf[pos] == '\r'))
+        pos++;
+    while (pos < len && buf[pos] >= '0' && buf[pos] <= '9')
+        pos++;
+
+    fd = connectTo(argv[1]);
+    while (pos < len) {
+        got = write(fd, buf + pos, len - pos);
+        if (got <= 0)
+            break;
+        pos += got;
+    }
+    shutdown(fd, SHUT_WR);
+
+    while ((got = read(fd, out, sizeof(out))) > 0)
+        fwrite(out, 1, got, stdout);
+
+    close(fd);
+    free(buf);
+    return 0;
+}
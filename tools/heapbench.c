@@ -0,0 +1,177 @@
+/*
+ * Micro-benchmark das filas de prioridade de struct/heap: insere n
+ * elementos com prioridades aleatórias, diminui a prioridade de u deles e
+ * retira todos, medindo cada fase no Heap encadeado e no IndexHeap. As
+ * duas filas devem retirar os elementos na mesma ordem.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "core/futoshiki.h"
+#include "struct/heap.h"
+
+#define USAGE "Uso: %s [-n elementos] [-u atualizacoes] [-s semente]\n"
+
+typedef struct Item {
+    size_t id;
+    long priority;
+} Item;
+
+typedef struct Timing {
+    uint64_t push;
+    uint64_t update;
+    uint64_t pop;
+} Timing;
+
+// Mesma ordem do IndexHeap: menor prioridade, depois menor id
+int compareItems(const void *a, const void *b) {
+    const Item *x = a, *y = b;
+
+    if (x->priority != y->priority)
+        return (x->priority > y->priority) - (x->priority < y->priority);
+    return (x->id > y->id) - (x->id < y->id);
+}
+
+void setPriority(void **value, void *arg) {
+    ((Item *) *value)->priority = *(long *) arg;
+}
+
+void benchHeap(const Item *initial, size_t n, const size_t *ids, const long *prios, size_t u,
+        size_t *order, Timing *t) {
+    Heap *h = heap_new(compareItems);
+    Item *items = malloc(n * sizeof(*items));
+    uint64_t start;
+    Item key;
+    size_t i;
+
+    // O Heap guarda ponteiros, e as atualizações alteram os próprios itens
+    for (i = 0; i < n; i++)
+        items[i] = initial[i];
+
+    start = futoshiki_now();
+    for (i = 0; i < n; i++)
+        heap_push(h, &items[i]);
+    t->push = futoshiki_now() - start;
+
+    start = futoshiki_now();
+    for (i = 0; i < u; i++) {
+        key = items[ids[i]];
+        heap_update(h, &key, setPriority, (void *) &prios[i]);
+    }
+    t->update = futoshiki_now() - start;
+
+    start = futoshiki_now();
+    for (i = 0; i < n; i++)
+        order[i] = ((Item *) heap_pop(h))->id;
+    t->pop = futoshiki_now() - start;
+
+    heap_destroy(h);
+    free(items);
+}
+
+void benchIndexHeap(const Item *items, size_t n, const size_t *ids, const long *prios, size_t u,
+        size_t *order, Timing *t) {
+    IndexHeap *h = indexheap_new(n);
+    uint64_t start;
+    size_t i;
+
+    start = futoshiki_now();
+    for (i = 0; i < n; i++)
+        indexheap_push(h, items[i].id, items[i].priority);
+    t->push = futoshiki_now() - start;
+
+    start = futoshiki_now();
+    for (i = 0; i < u; i++)
+        indexheap_push(h, ids[i], prios[i]);
+    t->update = futoshiki_now() - start;
+
+    start = futoshiki_now();
+    for (i = 0; i < n; i++)
+        order[i] = indexheap_pop(h);
+    t->pop = futoshiki_now() - start;
+
+    indexheap_destroy(h);
+}
+
+void printTiming(const char *name, const Timing *t, size_t n, size_t u) {
+    printf("%-10s insercao %8.1f ns/op   atualizacao %10.1f ns/op   remocao %8.1f ns/op\n",
+            name, (double) t->push / n, u > 0 ? (double) t->update / u : 0.0,
+            (double) t->pop / n);
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = 10000, u = 10000, i;
+    unsigned int seed = 1;
+    Item *items;
+    long *current;
+    size_t *ids, *orderHeap, *orderIndex;
+    long *prios;
+    Timing tHeap, tIndex;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:u:s:")) != -1) {
+        switch (opt) {
+            case 'n':
+                n = strtoul(optarg, NULL, 10);
+                break;
+            case 'u':
+                u = strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                seed = strtoul(optarg, NULL, 10);
+                break;
+            default:
+                fprintf(stderr, USAGE, argv[0]);
+                return 1;
+        }
+    }
+    if (optind != argc || n == 0) {
+        fprintf(stderr, USAGE, argv[0]);
+        return 1;
+    }
+
+    items = malloc(n * sizeof(*items));
+    current = malloc(n * sizeof(*current));
+    ids = malloc(u * sizeof(*ids));
+    prios = malloc(u * sizeof(*prios));
+    orderHeap = malloc(n * sizeof(*orderHeap));
+    orderIndex = malloc(n * sizeof(*orderIndex));
+
+    srand(seed);
+    for (i = 0; i < n; i++) {
+        items[i].id = i;
+        items[i].priority = rand() % (long) (4 * n);
+        current[i] = items[i].priority;
+    }
+
+    // Cada atualização diminui a prioridade de um elemento aleatório
+    for (i = 0; i < u; i++) {
+        ids[i] = rand() % n;
+        prios[i] = current[ids[i]] - 1 - rand() % (long) n;
+        current[ids[i]] = prios[i];
+    }
+
+    benchHeap(items, n, ids, prios, u, orderHeap, &tHeap);
+    benchIndexHeap(items, n, ids, prios, u, orderIndex, &tIndex);
+
+    printf("elementos: %zu, atualizacoes: %zu\n", n, u);
+    printTiming("Heap", &tHeap, n, u);
+    printTiming("IndexHeap", &tIndex, n, u);
+
+    for (i = 0; i < n && orderHeap[i] == orderIndex[i]; i++)
+        ;
+    if (i < n) {
+        fprintf(stderr, "ordens diferentes a partir da posicao %zu\n", i);
+        return 1;
+    }
+
+    free(items);
+    free(current);
+    free(ids);
+    free(prios);
+    free(orderHeap);
+    free(orderIndex);
+    return 0;
+}
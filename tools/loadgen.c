@@ -0,0 +1,319 @@
+/*
+ * Gerador de carga para o modo servidor. Envia os casos de um arquivo (no
+ * formato lido pelo Futoshiki) repetidamente por várias conexões, mantendo
+ * até D requisições pendentes em cada uma, e relata vazão e latências.
+ *
+ * Com -s, abre antes S conexões que enviam casos sem nunca ler as
+ * respostas; com -t, uma requisição não respondida em T milissegundos conta
+ * como falha. Juntos, testam que um cliente que não lê não prende os
+ * demais: "loadgen -s 1 -t 3000 SOCKET CASOS" sai com 1 se algum ficar sem
+ * resposta.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "core/futoshiki.h"
+
+#define USAGE \
+    "Uso: %s [-c conexoes] [-n requisicoes] [-d profundidade] [-s paradas]" \
+    " [-t ms] SOCKET CASOS\n"
+
+typedef struct Corpus {
+    char **texts;
+    size_t *lens;
+    unsigned int *sizes;
+    size_t n;
+} Corpus;
+
+typedef struct Client {
+    const char *path;
+    long timeout;
+    const Corpus *corpus;
+    unsigned long requests;
+    unsigned int depth;
+    unsigned long offset;
+    int fd;
+
+    // Instante de envio e latência de cada requisição, em ns
+    uint64_t *sent;
+    uint64_t *latency;
+    unsigned long failed;
+
+    // O receptor seta finished ao parar, respondidas ou não as requisições
+    unsigned long outstanding;
+    bool finished;
+    pthread_mutex_t lock;
+    pthread_cond_t room;
+} Client;
+
+Corpus *readCorpus(const char *name) {
+    FILE *f = fopen(name, "r");
+    Corpus *c;
+    char *buf;
+    size_t cap = 4096, len = 0, pos = 0;
+    size_t got;
+    long n;
+
+    if (f == NULL) {
+        perror(name);
+        exit(1);
+    }
+    buf = malloc(cap);
+    while ((got = fread(buf + len, 1, cap - len, f)) > 0) {
+        len += got;
+        if (len == cap) {
+            cap *= 2;
+            buf = realloc(buf, cap);
+        }
+    }
+    fclose(f);
+
+    c = malloc(sizeof(*c));
+    c->n = 0;
+    c->texts = NULL;
+    c->lens = NULL;
+    c->sizes = NULL;
+
+    // Pular a linha do número de casos e separar os tabuleiros
+    while (pos < len && buf[pos] != '\n')
+        pos++;
+    while ((n = puzzle_textLength(buf + pos, len - pos, true)) > 0) {
+        c->texts = realloc(c->texts, (c->n + 1) * sizeof(*c->texts));
+        c->lens = realloc(c->lens, (c->n + 1) * sizeof(*c->lens));
+        c->sizes = realloc(c->sizes, (c->n + 1) * sizeof(*c->sizes));
+        c->texts[c->n] = malloc(n + 1);
+        memcpy(c->texts[c->n], buf + pos, n);
+        c->texts[c->n][n] = '\n';
+        c->lens[c->n] = n + 1;
+        c->sizes[c->n] = strtoul(buf + pos, NULL, 10);
+        c->n++;
+        pos += n;
+    }
+
+    free(buf);
+    if (c->n == 0) {
+        fprintf(stderr, "%s: nenhum caso encontrado\n", name);
+        exit(1);
+    }
+    return c;
+}
+
+// Com timeout positivo, leituras que esperam mais que timeout ms falham
+int connectTo(const char *path, long timeout) {
+    struct sockaddr_un addr;
+    struct timeval tv;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    if (fd < 0 || connect(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+        perror(path);
+        exit(1);
+    }
+    if (timeout > 0) {
+        tv.tv_sec = timeout / 1000;
+        tv.tv_usec = (timeout % 1000) * 1000;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    }
+    return fd;
+}
+
+// Envia casos sem parar e sem ler as respostas, até o servidor deixar de ler
+// a conexão; fica bloqueada no envio até o fim do programa
+void *stallClient(void *arg) {
+    Client *cl = arg;
+    unsigned long i;
+    size_t k, pos;
+    ssize_t got;
+
+    cl->fd = connectTo(cl->path, 0);
+    for (i = 0; ; i++) {
+        k = i % cl->corpus->n;
+        for (pos = 0; pos < cl->corpus->lens[k]; pos += got) {
+            got = write(cl->fd, cl->corpus->texts[k] + pos, cl->corpus->lens[k] - pos);
+            if (got <= 0)
+                return NULL;
+        }
+    }
+}
+
+void *readAnswers(void *arg) {
+    Client *cl = arg;
+    FILE *in = fdopen(dup(cl->fd), "r");
+    char line[4096], status[32];
+    unsigned long seq, i, rows;
+    unsigned long long us;
+    long long assignments;
+
+    for (i = 0; i < cl->requests; i++) {
+        if (fgets(line, sizeof(line), in) == NULL)
+            break;
+        if (sscanf(line, "%lu %31s %llu %lld", &seq, status, &us, &assignments) != 4
+                || seq >= cl->requests)
+            break;
+
+        cl->latency[seq] = futoshiki_now() - cl->sent[seq];
+        if (strcmp(status, "solved") == 0) {
+            // Pular as linhas da grade
+            rows = cl->corpus->sizes[(cl->offset + seq) % cl->corpus->n];
+            while (rows-- > 0 && fgets(line, sizeof(line), in) != NULL)
+                ;
+        } else if (strcmp(status, "unsat") != 0) {
+            cl->failed++;
+        }
+
+        pthread_mutex_lock(&cl->lock);
+        cl->outstanding--;
+        pthread_cond_signal(&cl->room);
+        pthread_mutex_unlock(&cl->lock);
+    }
+
+    cl->failed += cl->requests - i;
+    fclose(in);
+
+    pthread_mutex_lock(&cl->lock);
+    cl->finished = true;
+    pthread_cond_signal(&cl->room);
+    pthread_mutex_unlock(&cl->lock);
+    return NULL;
+}
+
+void *runClient(void *arg) {
+    Client *cl = arg;
+    pthread_t receiver;
+    unsigned long i;
+    size_t k, pos;
+    ssize_t got;
+
+    cl->fd = connectTo(cl->path, cl->timeout);
+    pthread_create(&receiver, NULL, readAnswers, cl);
+
+    for (i = 0; i < cl->requests; i++) {
+        pthread_mutex_lock(&cl->lock);
+        while (cl->outstanding >= cl->depth && !cl->finished)
+            pthread_cond_wait(&cl->room, &cl->lock);
+        if (cl->finished) {
+            pthread_mutex_unlock(&cl->lock);
+            break;
+        }
+        cl->outstanding++;
+        pthread_mutex_unlock(&cl->lock);
+
+        k = (cl->offset + i) % cl->corpus->n;
+        cl->sent[i] = futoshiki_now();
+        for (pos = 0; pos < cl->corpus->lens[k]; pos += got) {
+            got = write(cl->fd, cl->corpus->texts[k] + pos, cl->corpus->lens[k] - pos);
+            if (got <= 0)
+                break;
+        }
+    }
+
+    shutdown(cl->fd, SHUT_WR);
+    pthread_join(receiver, NULL);
+    close(cl->fd);
+    return NULL;
+}
+
+int compareU64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char *argv[]) {
+    unsigned int conns = 1, depth = 16, stalled = 0;
+    unsigned long requests = 1000, i, total, failed = 0;
+    long timeout = 0;
+    uint64_t start, elapsed, *all;
+    Client *clients, *stalls;
+    pthread_t *threads, thread;
+    Corpus *corpus;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "c:n:d:s:t:")) != -1) {
+        switch (opt) {
+            case 'c':
+                conns = atoi(optarg);
+                break;
+            case 'n':
+                requests = strtoul(optarg, NULL, 10);
+                break;
+            case 'd':
+                depth = atoi(optarg);
+                break;
+            case 's':
+                stalled = atoi(optarg);
+                break;
+            case 't':
+                timeout = atol(optarg);
+                break;
+            default:
+                fprintf(stderr, USAGE, argv[0]);
+                return 1;
+        }
+    }
+    if (argc - optind != 2 || conns < 1 || depth < 1) {
+        fprintf(stderr, USAGE, argv[0]);
+        return 1;
+    }
+
+    corpus = readCorpus(argv[optind + 1]);
+    clients = calloc(conns, sizeof(*clients));
+    threads = malloc(conns * sizeof(*threads));
+
+    // Esperar que as conexões paradas encham seus buffers, para que os
+    // demais clientes já as encontrem paradas
+    stalls = calloc(stalled + 1, sizeof(*stalls));
+    for (i = 0; i < stalled; i++) {
+        stalls[i].path = argv[optind];
+        stalls[i].corpus = corpus;
+        pthread_create(&thread, NULL, stallClient, &stalls[i]);
+        pthread_detach(thread);
+    }
+    if (stalled > 0)
+        sleep(1);
+
+    start = futoshiki_now();
+    for (i = 0; i < conns; i++) {
+        clients[i].path = argv[optind];
+        clients[i].timeout = timeout;
+        clients[i].corpus = corpus;
+        clients[i].requests = requests / conns + (i < requests % conns);
+        clients[i].depth = depth;
+        clients[i].offset = i * (requests / conns);
+        clients[i].sent = calloc(clients[i].requests + 1, sizeof(uint64_t));
+        clients[i].latency = calloc(clients[i].requests + 1, sizeof(uint64_t));
+        pthread_mutex_init(&clients[i].lock, NULL);
+        pthread_cond_init(&clients[i].room, NULL);
+        pthread_create(&threads[i], NULL, runClient, &clients[i]);
+    }
+
+    all = malloc((requests + 1) * sizeof(*all));
+    total = 0;
+    for (i = 0; i < conns; i++) {
+        pthread_join(threads[i], NULL);
+        memcpy(all + total, clients[i].latency, clients[i].requests * sizeof(*all));
+        total += clients[i].requests;
+        failed += clients[i].failed;
+    }
+    elapsed = futoshiki_now() - start;
+
+    qsort(all, total, sizeof(*all), compareU64);
+    printf("requisicoes: %lu (%lu falhas)\n", total, failed);
+    printf("vazao: %.1f req/s\n", total / (elapsed / 1e9));
+    if (total > 0) {
+        printf("latencia p50: %.1f us\n", all[total / 2] / 1e3);
+        printf("latencia p99: %.1f us\n", all[(total * 99) / 100] / 1e3);
+        printf("latencia max: %.1f us\n", all[total - 1] / 1e3);
+    }
+
+    return failed > 0;
+}